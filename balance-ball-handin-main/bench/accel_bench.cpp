@@ -0,0 +1,153 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include "accelerometer.hpp"
+#include "bench.hpp"
+#include "broker.hpp"
+#include "sim_bmi160.hpp"
+
+// Acquisition pipeline benchmark against the simulated BMI160.
+// Usage: accel_bench [--format csv|json] [--seconds S] [--replay motion.csv]
+//
+// Runs Accelerometer in polling and FIFO mode, woken by the fallback timer
+// or the simulated INT1 line, at 1600 Hz in real time and at 8x/32x
+// simulated time, and reports delivered samples/s, lost samples, bus
+// transactions and bytes per sample, latency from sample to delivery and
+// the CPU time of the acquisition thread. The simulated bus spins for the
+// modelled transfer time, so cpu_percent includes bus_utilization.
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string mode;
+  std::string wakeup;
+  double timeScale = 1;
+  double seconds = 0;
+  uint64_t generated = 0;
+  uint64_t delivered = 0;
+  uint64_t overflows = 0;
+  double transactionsPerSample = 0;
+  double bytesPerSample = 0;
+  double busUtilization = 0;
+  double cpuPercent = 0;
+  uint64_t p50 = 0, p99 = 0, max = 0; // ns
+};
+
+// Runs on the acquisition thread (sync delivery), so one writer
+class LatencyConsumer : public IConsumer {
+public:
+  std::atomic<uint64_t> count{0};
+  LatencyHistogram latency;
+
+  void onMessage(const Message &msg) override {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - msg.timestamp).count();
+    latency.record(ns > 0 ? ns : 0);
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+static double threadCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static Result run(AccelMode mode, bool interrupt, double timeScale, double seconds, const std::string &replay) {
+  SimBMI160 sim(BusTiming{}, timeScale);
+  if (!replay.empty())
+    sim.replay(replay);
+  else
+    sim.setMotion([](double t) {
+      Motion m;
+      m.accel[0] = 0.3 * std::sin(2 * M_PI * 0.5 * t);
+      m.accel[1] = 0.3 * std::cos(2 * M_PI * 0.3 * t);
+      m.accel[2] = 0.9;
+      return m;
+    });
+  sim.setNoise(0.01, 0.5);
+
+  auto consumer = std::make_shared<LatencyConsumer>();
+  Broker::getInstance().subscribe(topics::accl, consumer);
+
+  Accelerometer accl(sim, mode, 1600, 16);
+  if (interrupt)
+    accl.setEventSource(sim.interrupt());
+
+  auto before = sim.stats();
+  double cpu = 0;
+  auto start = Clock::now();
+  std::thread t([&]() {
+    double c0 = threadCpuSeconds();
+    accl.accelerometerThread();
+    cpu = threadCpuSeconds() - c0;
+  });
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  accl.stop();
+  t.join();
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+  Broker::getInstance().unsubscribe(topics::accl, consumer);
+
+  auto after = sim.stats();
+  HistogramSnapshot h;
+  consumer->latency.addTo(h);
+
+  Result r;
+  r.mode = mode == AccelMode::Fifo ? "fifo" : "polling";
+  r.wakeup = interrupt ? "int1" : "timer";
+  r.timeScale = timeScale;
+  r.seconds = elapsed.count();
+  r.generated = after.samplesGenerated - before.samplesGenerated;
+  r.delivered = consumer->count.load();
+  r.overflows = after.fifoOverflows - before.fifoOverflows;
+  uint64_t samples = r.delivered ? r.delivered : 1;
+  r.transactionsPerSample = double(after.transactions - before.transactions) / samples;
+  r.bytesPerSample = double(after.bytes - before.bytes) / samples;
+  r.busUtilization = (after.busyNs - before.busyNs) * 1e-9 / r.seconds;
+  r.cpuPercent = 100 * cpu / r.seconds;
+  r.p50 = h.percentile(0.5);
+  r.p99 = h.percentile(0.99);
+  r.max = h.max;
+  return r;
+}
+
+static void addRow(bench::Report &report, const Result &r) {
+  report.row()
+      .add("mode", r.mode)
+      .add("wakeup", r.wakeup)
+      .add("time_scale", r.timeScale)
+      .add("seconds", r.seconds)
+      .add("generated", r.generated)
+      .add("delivered", r.delivered)
+      .add("samples_per_sec", r.delivered / r.seconds)
+      .add("fifo_overflows", r.overflows)
+      .add("transactions_per_sample", r.transactionsPerSample)
+      .add("bytes_per_sample", r.bytesPerSample)
+      .add("bus_utilization", r.busUtilization)
+      .add("cpu_percent", r.cpuPercent)
+      .add("p50_ns", r.p50)
+      .add("p99_ns", r.p99)
+      .add("max_ns", r.max);
+}
+
+int main(int argc, char *argv[]) {
+  bench::Args args(argc, argv, "[--seconds S] [--replay motion.csv]");
+  if (!args.ok())
+    return 1;
+  double seconds = args.number("--seconds", 1);
+  std::string replay = args.text("--replay");
+
+  bench::Report report;
+  for (auto mode : {AccelMode::Polling, AccelMode::Fifo})
+    for (bool interrupt : {false, true})
+      addRow(report, run(mode, interrupt, 1, seconds, replay));
+
+  for (double scale : {8.0, 32.0})
+    addRow(report, run(AccelMode::Fifo, true, scale, seconds, replay));
+
+  report.print(args.json());
+  return 0;
+}
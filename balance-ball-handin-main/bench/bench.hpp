@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ---------------------------
+// Benchmark plumbing
+// ---------------------------
+// Every benchmark takes --format csv|json and its own "--name value"
+// options, and prints one row per case: CSV with a header line, or a JSON
+// array of objects.
+namespace bench {
+
+class Args {
+public:
+  // usage lists the options besides --format, e.g. "[--frames N] [--pbm DIR]";
+  // other options print it and make ok() false
+  Args(int argc, char *argv[], const std::string &usage) {
+    for (int i = 1; i < argc; ++i) {
+      bool known = std::strncmp(argv[i], "--", 2) == 0 &&
+                   (std::strcmp(argv[i], "--format") == 0 || usage.find(std::string(argv[i]) + ' ') != std::string::npos);
+      if (!known || i + 1 >= argc) {
+        std::cerr << "Usage: " << argv[0] << " [--format csv|json] " << usage << "\n";
+        valid = false;
+        return;
+      }
+      options.push_back({argv[i], argv[i + 1]});
+      ++i;
+    }
+  }
+
+  bool ok() const { return valid; }
+  bool json() const { return text("--format") == "json"; }
+
+  std::string text(const char *name, const std::string &fallback = "") const {
+    for (auto it = options.rbegin(); it != options.rend(); ++it)
+      if (it->first == name)
+        return it->second;
+    return fallback;
+  }
+
+  double number(const char *name, double fallback) const {
+    std::string value = text(name);
+    return value.empty() ? fallback : std::strtod(value.c_str(), nullptr);
+  }
+
+private:
+  std::vector<std::pair<std::string, std::string>> options;
+  bool valid = true;
+};
+
+class Report {
+public:
+  // Starts the next row, fields follow with add()
+  Report &row() {
+    rows.emplace_back();
+    return *this;
+  }
+
+  Report &add(const char *name, const std::string &value) { return field(name, value, true); }
+  Report &add(const char *name, const char *value) { return field(name, value, true); }
+
+  template <typename T>
+  Report &add(const char *name, T value) {
+    std::ostringstream s;
+    s << value;
+    return field(name, s.str(), false);
+  }
+
+  void print(bool json, std::ostream &out = std::cout) const {
+    if (json) {
+      out << "[\n";
+      for (std::size_t r = 0; r < rows.size(); ++r) {
+        out << "  {";
+        for (std::size_t f = 0; f < rows[r].size(); ++f) {
+          const Field &field = rows[r][f];
+          out << (f ? ", " : "") << '"' << field.name << "\": ";
+          if (field.quoted)
+            out << '"' << field.value << '"';
+          else
+            out << field.value;
+        }
+        out << "}" << (r + 1 < rows.size() ? ",\n" : "\n");
+      }
+      out << "]\n";
+      return;
+    }
+
+    // The first row names the columns
+    for (std::size_t f = 0; !rows.empty() && f < rows[0].size(); ++f)
+      out << (f ? "," : "") << rows[0][f].name;
+    out << '\n';
+    for (auto &row : rows) {
+      for (std::size_t f = 0; f < row.size(); ++f)
+        out << (f ? "," : "") << row[f].value;
+      out << '\n';
+    }
+  }
+
+private:
+  struct Field {
+    std::string name;
+    std::string value;
+    bool quoted;
+  };
+  std::vector<std::vector<Field>> rows;
+
+  Report &field(const char *name, const std::string &value, bool quoted) {
+    rows.back().push_back({name, value, quoted});
+    return *this;
+  }
+};
+
+} // namespace bench
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.hpp"
+#include "broker.hpp"
+
+// Broker micro-benchmarks, no hardware needed.
+// Usage: broker_bench [--format csv|json] [--messages N]
+//
+//   latency    publish() call latency percentiles, one consumer
+//              (latency_nometrics: the same with BrokerMetrics disabled)
+//   fanout     delivered messages/s for 1..64 consumers
+//   contention published messages/s for 1..8 publisher threads
+//   churn      cost of a subscribe + unsubscribe pair
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string bench;
+  std::string mode;
+  int publishers = 1;
+  int consumers = 1;
+  uint64_t ops = 0;
+  double seconds = 0;
+  double p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0; // ns
+};
+
+class CountingConsumer : public IConsumer {
+public:
+  std::atomic<uint64_t> count{0};
+  void onMessage(const Message &) override { count.fetch_add(1, std::memory_order_relaxed); }
+};
+
+static const char *modeName(DeliveryMode mode) {
+  switch (mode) {
+  case DeliveryMode::Sync: return "sync";
+  case DeliveryMode::Async: return "async";
+  case DeliveryMode::Latest: return "latest";
+  }
+  return "?";
+}
+
+static SubscriptionOptions optionsFor(DeliveryMode mode) {
+  SubscriptionOptions options;
+  options.mode = mode;
+  options.queueDepth = 1024;
+  options.overflow = OverflowPolicy::Block;
+  return options;
+}
+
+static double percentile(std::vector<uint32_t> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  std::size_t i = std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()));
+  return sorted[i];
+}
+
+static std::vector<std::shared_ptr<CountingConsumer>> addConsumers(int n, DeliveryMode mode) {
+  std::vector<std::shared_ptr<CountingConsumer>> consumers;
+  for (int i = 0; i < n; ++i) {
+    consumers.push_back(std::make_shared<CountingConsumer>());
+    Broker::getInstance().subscribe(topics::accl, consumers.back(), optionsFor(mode));
+  }
+  return consumers;
+}
+
+static void removeConsumers(std::vector<std::shared_ptr<CountingConsumer>> &consumers) {
+  for (auto &c : consumers)
+    Broker::getInstance().unsubscribe(topics::accl, c);
+  consumers.clear();
+}
+
+static void waitForDelivery(const std::vector<std::shared_ptr<CountingConsumer>> &consumers, uint64_t each) {
+  for (auto &c : consumers)
+    while (c->count.load(std::memory_order_relaxed) < each)
+      std::this_thread::yield();
+}
+
+// ---------------------------
+// Benchmarks
+// ---------------------------
+static Result benchLatency(DeliveryMode mode, uint64_t messages, bool metrics) {
+  BrokerMetrics::getInstance().setEnabled(metrics);
+  auto consumers = addConsumers(1, mode);
+  std::vector<uint32_t> samples(messages);
+
+  auto start = Clock::now();
+  for (uint64_t i = 0; i < messages; ++i) {
+    auto t0 = Clock::now();
+    Broker::getInstance().publish(topics::accl, AccelerometerData{double(i), 0, 0});
+    auto t1 = Clock::now();
+    samples[i] = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+  }
+  waitForDelivery(consumers, messages);
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+  removeConsumers(consumers);
+  BrokerMetrics::getInstance().setEnabled(true);
+
+  std::sort(samples.begin(), samples.end());
+  Result r;
+  r.bench = metrics ? "latency" : "latency_nometrics";
+  r.mode = modeName(mode);
+  r.ops = messages;
+  r.seconds = elapsed.count();
+  r.p50 = percentile(samples, 0.50);
+  r.p90 = percentile(samples, 0.90);
+  r.p99 = percentile(samples, 0.99);
+  r.p999 = percentile(samples, 0.999);
+  r.max = samples.empty() ? 0 : samples.back();
+  return r;
+}
+
+static Result benchFanout(DeliveryMode mode, int fanout, uint64_t messages) {
+  auto consumers = addConsumers(fanout, mode);
+
+  auto start = Clock::now();
+  for (uint64_t i = 0; i < messages; ++i)
+    Broker::getInstance().publish(topics::accl, AccelerometerData{double(i), 0, 0});
+  waitForDelivery(consumers, messages);
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+  removeConsumers(consumers);
+
+  Result r;
+  r.bench = "fanout";
+  r.mode = modeName(mode);
+  r.consumers = fanout;
+  r.ops = messages * fanout; // deliveries
+  r.seconds = elapsed.count();
+  return r;
+}
+
+static Result benchContention(DeliveryMode mode, int publishers, uint64_t messages) {
+  auto consumers = addConsumers(1, mode);
+  uint64_t perThread = messages / publishers;
+
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < publishers; ++t)
+    threads.emplace_back([&]() {
+      while (!go)
+        std::this_thread::yield();
+      for (uint64_t i = 0; i < perThread; ++i)
+        Broker::getInstance().publish(topics::accl, AccelerometerData{double(i), 0, 0});
+    });
+
+  auto start = Clock::now();
+  go = true;
+  for (auto &t : threads)
+    t.join();
+  waitForDelivery(consumers, perThread * publishers);
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+  removeConsumers(consumers);
+
+  Result r;
+  r.bench = "contention";
+  r.mode = modeName(mode);
+  r.publishers = publishers;
+  r.ops = perThread * publishers;
+  r.seconds = elapsed.count();
+  return r;
+}
+
+static Result benchChurn(int existing, uint64_t rounds) {
+  auto consumers = addConsumers(existing, DeliveryMode::Sync);
+  auto churner = std::make_shared<CountingConsumer>();
+  std::vector<uint32_t> samples(rounds);
+
+  auto start = Clock::now();
+  for (uint64_t i = 0; i < rounds; ++i) {
+    auto t0 = Clock::now();
+    Broker::getInstance().subscribe(topics::accl, churner);
+    Broker::getInstance().unsubscribe(topics::accl, churner);
+    auto t1 = Clock::now();
+    samples[i] = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+  }
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+  removeConsumers(consumers);
+
+  std::sort(samples.begin(), samples.end());
+  Result r;
+  r.bench = "churn";
+  r.mode = "sync";
+  r.consumers = existing;
+  r.ops = rounds;
+  r.seconds = elapsed.count();
+  r.p50 = percentile(samples, 0.50);
+  r.p90 = percentile(samples, 0.90);
+  r.p99 = percentile(samples, 0.99);
+  r.p999 = percentile(samples, 0.999);
+  r.max = samples.empty() ? 0 : samples.back();
+  return r;
+}
+
+// ---------------------------
+// Output
+// ---------------------------
+static void addRow(bench::Report &report, const Result &r) {
+  report.row()
+      .add("bench", r.bench)
+      .add("mode", r.mode)
+      .add("publishers", r.publishers)
+      .add("consumers", r.consumers)
+      .add("ops", r.ops)
+      .add("seconds", r.seconds)
+      .add("ops_per_sec", r.ops / r.seconds)
+      .add("p50_ns", r.p50)
+      .add("p90_ns", r.p90)
+      .add("p99_ns", r.p99)
+      .add("p999_ns", r.p999)
+      .add("max_ns", r.max);
+}
+
+int main(int argc, char *argv[]) {
+  bench::Args args(argc, argv, "[--messages N]");
+  if (!args.ok())
+    return 1;
+  auto messages = uint64_t(args.number("--messages", 200000));
+
+  MessagePool::getInstance().reserve(4096);
+
+  std::vector<Result> results;
+  for (bool metrics : {true, false})
+    for (auto mode : {DeliveryMode::Sync, DeliveryMode::Async})
+      results.push_back(benchLatency(mode, messages, metrics));
+
+  for (auto mode : {DeliveryMode::Sync, DeliveryMode::Async})
+    for (int fanout : {1, 2, 4, 8, 16, 32, 64})
+      results.push_back(benchFanout(mode, fanout, messages / fanout));
+
+  for (auto mode : {DeliveryMode::Sync, DeliveryMode::Async})
+    for (int publishers : {1, 2, 4, 8})
+      results.push_back(benchContention(mode, publishers, messages));
+
+  for (int existing : {0, 8, 64})
+    results.push_back(benchChurn(existing, messages / 100));
+
+  bench::Report report;
+  for (auto &r : results)
+    addRow(report, r);
+  report.print(args.json());
+  return 0;
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "sample_decode.hpp"
+
+// Raw sample decode kernel benchmark, no hardware needed.
+// Usage: decode_bench [--format csv|json] [--frames N]
+//
+// Reports ns per frame and frames/s of decodeFrames and of
+// decodeFramesScalar (the reference) for a single watermark (16 frames), a
+// full FIFO (170 or 85 frames) and a large batch, with accelerometer-only
+// (6 byte) and gyro+accel (12 byte) frames. tests/decode_test checks that
+// both give the same result.
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string kernel;
+  int sensors = 1;
+  std::size_t batch = 0;
+  uint64_t frames = 0;
+  double seconds = 0;
+};
+
+using Kernel = void (*)(const uint8_t *, std::size_t, int, const float *, const Vec3Array *);
+
+// Scales of a BMI160 frame: gyro (degrees/s) then accelerometer (g)
+static const float scales[2] = {1 / 16.4f, 1 / 16384.0f};
+
+struct Output {
+  std::vector<float> data;
+  Vec3Array arrays[2];
+
+  explicit Output(std::size_t frames) : data(6 * frames) {
+    for (int s = 0; s < 2; ++s)
+      arrays[s] = {&data[(3 * s) * frames], &data[(3 * s + 1) * frames], &data[(3 * s + 2) * frames]};
+  }
+};
+
+static std::vector<uint8_t> randomFrames(std::size_t frames, int sensors, std::mt19937 &rng) {
+  std::vector<uint8_t> raw(frames * sensors * 6);
+  std::uniform_int_distribution<int> byte(0, 255);
+  for (auto &b : raw)
+    b = static_cast<uint8_t>(byte(rng));
+  return raw;
+}
+
+static Result measure(const char *name, Kernel kernel, int sensors, std::size_t batch, uint64_t totalFrames) {
+  std::mt19937 rng(batch);
+  auto raw = randomFrames(batch, sensors, rng);
+  Output out(batch);
+
+  uint64_t rounds = std::max<uint64_t>(1, totalFrames / batch);
+  for (int i = 0; i < 100; ++i)
+    kernel(raw.data(), batch, sensors, scales, out.arrays);
+
+  auto start = Clock::now();
+  for (uint64_t i = 0; i < rounds; ++i) {
+    kernel(raw.data(), batch, sensors, scales, out.arrays);
+    // Keep the stores alive between rounds
+    asm volatile("" : : "r"(out.data.data()) : "memory");
+  }
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  Result r;
+  r.kernel = name;
+  r.sensors = sensors;
+  r.batch = batch;
+  r.frames = rounds * batch;
+  r.seconds = elapsed.count();
+  return r;
+}
+
+static void addRow(bench::Report &report, const Result &r) {
+  report.row()
+      .add("kernel", r.kernel)
+      .add("sensors", r.sensors)
+      .add("batch", r.batch)
+      .add("frames", r.frames)
+      .add("seconds", r.seconds)
+      .add("ns_per_frame", r.seconds * 1e9 / r.frames)
+      .add("frames_per_sec", r.frames / r.seconds);
+}
+
+int main(int argc, char *argv[]) {
+  bench::Args args(argc, argv, "[--frames N]");
+  if (!args.ok())
+    return 1;
+  auto frames = uint64_t(args.number("--frames", 20000000));
+
+  bench::Report report;
+  for (int sensors = 1; sensors <= 2; ++sensors) {
+    std::size_t fullFifo = 1024 / (6 * sensors);
+    for (std::size_t batch : {std::size_t(16), fullFifo, std::size_t(4096)}) {
+      addRow(report, measure(decodeKernelName(), decodeFrames, sensors, batch, frames));
+      addRow(report, measure("reference", decodeFramesScalar, sensors, batch, frames));
+    }
+  }
+  report.print(args.json());
+  return 0;
+}
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "bench.hpp"
+#include "broker.hpp"
+#include "input_thread.hpp"
+
+// Button input benchmark with pipes in place of the device nodes.
+// Usage: input_bench [--format csv|json] [--presses N]
+//
+// Six buttons on one InputThread. A writer thread per button presses it N
+// times: five bouncing edges 200 us apart on press and on release, 30 ms
+// held and 30 ms between presses. Reports the state changes published
+// (2 per press when debouncing works), latency from the first edge of a
+// press or release to delivery, and the CPU time of the input thread.
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int buttonCount = 6;
+
+struct Result {
+  int debounceMs = 0;
+  uint64_t edges = 0;
+  uint64_t published = 0;
+  uint64_t expected = 0;
+  double seconds = 0;
+  double cpuPercent = 0;
+  uint64_t p50 = 0, p99 = 0, max = 0; // ns
+};
+
+// Runs on the input thread (sync delivery), so one writer
+class LatencyConsumer : public IConsumer {
+public:
+  std::atomic<int64_t> edgeAt[buttonCount] = {}; // ns, first edge of the current transition
+  std::atomic<bool> measuring{false};
+  std::atomic<uint64_t> count{0};
+  LatencyHistogram latency;
+
+  void onButton(const ButtonData &data) override {
+    if (!measuring)
+      return;
+    auto now = Clock::now().time_since_epoch().count();
+    auto ns = now - edgeAt[data.gpio].load();
+    latency.record(ns > 0 ? ns : 0);
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+static double threadCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Bounces to `level`: 5 edges ending at it
+static uint64_t bounce(int fd, char level, std::atomic<int64_t> &edgeAt) {
+  char other = level == '0' ? '1' : '0';
+  const char pattern[] = {level, other, level, other, level};
+  edgeAt = Clock::now().time_since_epoch().count();
+  for (char c : pattern) {
+    if (write(fd, &c, 1) != 1)
+      perror("write()");
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  return sizeof(pattern);
+}
+
+static Result run(int debounceMs, int presses) {
+  auto consumer = std::make_shared<LatencyConsumer>();
+  std::vector<Topic<ButtonData>> topics;
+  for (int i = 0; i < buttonCount; ++i) {
+    std::string name = "bench/btn/" + std::to_string(i);
+    topics.push_back(Broker::getInstance().registerTopic<ButtonData>(name, Priority::High));
+    Broker::getInstance().subscribe(topics.back(), consumer);
+  }
+
+  InputThread input;
+  int writeFds[buttonCount];
+  for (int i = 0; i < buttonCount; ++i) {
+    int fds[2];
+    if (pipe(fds) < 0) {
+      perror("pipe()");
+      std::exit(1);
+    }
+    writeFds[i] = fds[1];
+    // Start released so the first press is a change
+    if (write(fds[1], "1", 1) != 1)
+      perror("write()");
+    auto button = std::make_unique<Button>(fds[0], i, topics[i], std::chrono::milliseconds(debounceMs));
+    if (!input.add(button)) {
+      std::cerr << "Can't watch button " << i << "\n";
+      std::exit(1);
+    }
+  }
+
+  double cpu = 0;
+  std::thread reader([&]() {
+    double c0 = threadCpuSeconds();
+    input.run();
+    cpu = threadCpuSeconds() - c0;
+  });
+
+  // Let the initial level through, it is not counted
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  consumer->measuring = true;
+
+  std::atomic<uint64_t> edges{0};
+  auto start = Clock::now();
+  std::vector<std::thread> writers;
+  for (int i = 0; i < buttonCount; ++i)
+    writers.emplace_back([&, i]() {
+      for (int p = 0; p < presses; ++p) {
+        edges += bounce(writeFds[i], '0', consumer->edgeAt[i]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        edges += bounce(writeFds[i], '1', consumer->edgeAt[i]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+      }
+    });
+  for (auto &w : writers)
+    w.join();
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  input.stop();
+  reader.join();
+  for (int i = 0; i < buttonCount; ++i) {
+    close(writeFds[i]);
+    Broker::getInstance().unsubscribe(topics[i], consumer);
+  }
+
+  HistogramSnapshot h;
+  consumer->latency.addTo(h);
+
+  Result r;
+  r.debounceMs = debounceMs;
+  r.edges = edges.load();
+  r.published = consumer->count.load();
+  r.expected = uint64_t(2) * presses * buttonCount;
+  r.seconds = elapsed.count();
+  r.cpuPercent = 100 * cpu / r.seconds;
+  r.p50 = h.percentile(0.5);
+  r.p99 = h.percentile(0.99);
+  r.max = h.max;
+  return r;
+}
+
+static void addRow(bench::Report &report, const Result &r) {
+  report.row()
+      .add("buttons", buttonCount)
+      .add("debounce_ms", r.debounceMs)
+      .add("edges", r.edges)
+      .add("published", r.published)
+      .add("expected", r.expected)
+      .add("seconds", r.seconds)
+      .add("cpu_percent", r.cpuPercent)
+      .add("p50_ns", r.p50)
+      .add("p99_ns", r.p99)
+      .add("max_ns", r.max);
+}
+
+int main(int argc, char *argv[]) {
+  bench::Args args(argc, argv, "[--presses N]");
+  if (!args.ok())
+    return 1;
+  int presses = int(args.number("--presses", 20));
+
+  bench::Report report;
+  for (int debounceMs : {0, 5, 20})
+    addRow(report, run(debounceMs, presses));
+  report.print(args.json());
+  return 0;
+}
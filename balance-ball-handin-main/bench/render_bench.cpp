@@ -0,0 +1,131 @@
+#include <chrono>
+#include <string>
+#include "bench.hpp"
+#include "display.hpp"
+#include "sim_ssd1306.hpp"
+
+// Rendering benchmark on the simulated SSD1306, no hardware needed.
+// Usage: render_bench [--format csv|json] [--frames N] [--pbm DIR] [--hash-log FILE]
+//
+// Runs the real drawing path, Display::drawDisplay with its diff and
+// batched I2C writes, against SimSSD1306, and reports frames/s, bytes,
+// syscalls and bus time per frame for a still, a moving and a moving and
+// scoring ball, with an infinitely fast bus and at 400 kHz and 1 MHz.
+// --pbm and --hash-log record 300 frames of the moving and scoring ball
+// first, as PBM images or as a hash per frame to compare runs with.
+// tests/render_test checks that the panel shows what was drawn.
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string bus;
+  std::string motion;
+  uint64_t frames = 0;
+  double seconds = 0;
+  DisplayStats display;
+  I2CStats i2c;
+};
+
+enum class Motion { Still, Moving, Scoring };
+
+static const char *motionName(Motion m) {
+  return m == Motion::Still ? "still" : m == Motion::Moving ? "moving" : "scoring";
+}
+
+// Back and forth between 0 and max
+static int bounce(uint64_t i, int max) {
+  int p = int(i % (2 * max));
+  return p < max ? p : 2 * max - p;
+}
+
+static GameState stateAt(Motion m, uint64_t i) {
+  if (m == Motion::Still)
+    return {60, 12, 100};
+  GameState s{bounce(i, OLED_WIDTH - 8), bounce(i / 2, OLED_HEIGHT - 8), 100};
+  if (m == Motion::Scoring)
+    s.score = int(i * 37);
+  return s;
+}
+
+static bool record(const std::string &pbmDir, const std::string &hashLog) {
+  SimSSD1306 sim(I2CTiming::instant());
+  if (!pbmDir.empty())
+    sim.dumpFrames(pbmDir);
+  if (!hashLog.empty() && !sim.logHashes(hashLog))
+    return false;
+
+  uint8_t buffer[OLED_BUFFER_SIZE];
+  Display display(sim, buffer);
+  for (uint64_t i = 0; i < 300; ++i)
+    display.drawDisplay(stateAt(Motion::Scoring, i));
+  sim.waitIdle();
+  return true;
+}
+
+static Result measure(const char *bus, I2CTiming timing, Motion motion, uint64_t frames) {
+  SimSSD1306 sim(timing);
+  uint8_t buffer[OLED_BUFFER_SIZE];
+  Display display(sim, buffer);
+
+  // The first frame goes out whole, leave it out
+  display.drawDisplay(stateAt(motion, 0));
+  sim.waitIdle();
+  DisplayStats displayBefore = display.stats();
+  I2CStats i2cBefore = sim.stats();
+
+  auto start = Clock::now();
+  for (uint64_t i = 1; i <= frames; ++i)
+    display.drawDisplay(stateAt(motion, i));
+  sim.waitIdle();
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  DisplayStats d = display.stats();
+  I2CStats c = sim.stats();
+  Result r;
+  r.bus = bus;
+  r.motion = motionName(motion);
+  r.frames = frames;
+  r.seconds = elapsed.count();
+  r.display.bytes = d.bytes - displayBefore.bytes;
+  r.display.writes = d.writes - displayBefore.writes;
+  r.i2c.syscalls = c.syscalls - i2cBefore.syscalls;
+  r.i2c.busNs = c.busNs - i2cBefore.busNs;
+  return r;
+}
+
+static void addRow(bench::Report &report, const Result &r) {
+  report.row()
+      .add("bus", r.bus)
+      .add("motion", r.motion)
+      .add("frames", r.frames)
+      .add("seconds", r.seconds)
+      .add("frames_per_sec", r.frames / r.seconds)
+      .add("bytes_per_frame", double(r.display.bytes) / r.frames)
+      .add("writes_per_frame", double(r.display.writes) / r.frames)
+      .add("syscalls_per_frame", double(r.i2c.syscalls) / r.frames)
+      .add("bus_us_per_frame", r.i2c.busNs / 1000.0 / r.frames);
+}
+
+int main(int argc, char *argv[]) {
+  bench::Args args(argc, argv, "[--frames N] [--pbm DIR] [--hash-log FILE]");
+  if (!args.ok())
+    return 1;
+  auto frames = uint64_t(args.number("--frames", 3000));
+  std::string pbmDir = args.text("--pbm"), hashLog = args.text("--hash-log");
+
+  if ((!pbmDir.empty() || !hashLog.empty()) && !record(pbmDir, hashLog))
+    return 1;
+
+  const std::pair<const char *, I2CTiming> buses[] = {
+      {"instant", I2CTiming::instant()},
+      {"400kHz", I2CTiming{}},
+      {"1MHz", I2CTiming{1000000, std::chrono::nanoseconds(50000)}},
+  };
+
+  bench::Report report;
+  for (auto &[name, timing] : buses)
+    for (Motion motion : {Motion::Still, Motion::Moving, Motion::Scoring})
+      addRow(report, measure(name, timing, motion, frames));
+  report.print(args.json());
+  return 0;
+}
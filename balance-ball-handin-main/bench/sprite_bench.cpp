@@ -0,0 +1,82 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "sprite_paths.hpp"
+
+// Frame drawing benchmark, no hardware needed.
+// Usage: sprite_bench [--format csv|json] [--frames N]
+//
+// Draws a ball moving over every row offset plus the score text, the way
+// Display does (erase, cached score, pre-shifted blit), and the way the
+// OLED library's generic path does (clear the buffer, one pixel at a time
+// for the bitmap and every character), and reports frames/s with a
+// constant score and with a score that changes every frame.
+// tests/sprite_test checks that both give the same page buffer.
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string path;
+  std::string score;
+  uint64_t frames = 0;
+  double seconds = 0;
+};
+
+template <typename Draw>
+static Result measure(const char *path, bool changingScore, uint64_t frames, Draw draw) {
+  uint8_t frame[OLED_BUFFER_SIZE] = {0};
+  GameState state{0, 0, 1234};
+
+  auto step = [&](uint64_t i) {
+    // Bounce over the whole screen, through every row offset
+    state.ball_x = int(i % (OLED_WIDTH - 8));
+    state.ball_y = int(i % (OLED_HEIGHT - 8));
+    if (changingScore)
+      state.score += 7;
+    draw(frame, state);
+    asm volatile("" : : "r"(frame) : "memory");
+  };
+
+  for (uint64_t i = 0; i < 1000; ++i)
+    step(i);
+
+  auto start = Clock::now();
+  for (uint64_t i = 0; i < frames; ++i)
+    step(i);
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  Result r;
+  r.path = path;
+  r.score = changingScore ? "changing" : "constant";
+  r.frames = frames;
+  r.seconds = elapsed.count();
+  return r;
+}
+
+int main(int argc, char *argv[]) {
+  bench::Args args(argc, argv, "[--frames N]");
+  if (!args.ok())
+    return 1;
+  auto frames = uint64_t(args.number("--frames", 2000000));
+
+  std::vector<Result> results;
+  for (bool changing : {false, true}) {
+    Blitter blitter;
+    results.push_back(measure("blit", changing, frames,
+                              [&](uint8_t *frame, const GameState &s) { blitter.draw(frame, s); }));
+    results.push_back(measure("per-pixel", changing, frames, drawReference));
+  }
+
+  bench::Report report;
+  for (auto &r : results)
+    report.row()
+        .add("path", r.path)
+        .add("score", r.score)
+        .add("frames", r.frames)
+        .add("seconds", r.seconds)
+        .add("ns_per_frame", r.seconds * 1e9 / r.frames)
+        .add("frames_per_sec", r.frames / r.seconds);
+  report.print(args.json());
+  return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include "game_state.hpp"
+#include "sprite.hpp"
+
+// The two ways of drawing a frame that sprite_bench times and
+// tests/sprite_test compares.
+
+// ---------------------------
+// Per-pixel reference, what OLEDBitmap and print do
+// ---------------------------
+inline void drawPixel(uint8_t *frame, int x, int y) {
+  if (x < 0 || x >= OLED_WIDTH || y < 0 || y >= OLED_HEIGHT)
+    return;
+  frame[(y / 8) * OLED_WIDTH + x] |= uint8_t(1 << (y & 7));
+}
+
+inline void drawReference(uint8_t *frame, const GameState &state) {
+  std::memset(frame, 0, OLED_BUFFER_SIZE);
+
+  for (int row = 0; row < 8; ++row)
+    for (int col = 0; col < 8; ++col)
+      if (ballBitmap[row] & (0x80 >> col))
+        drawPixel(frame, state.ball_x + col, state.ball_y + row);
+
+  char text[24];
+  int length = std::snprintf(text, sizeof(text), "Score %d", state.score);
+  for (int i = 0; i < length; ++i) {
+    const uint8_t *glyph = glyph5x7(text[i]);
+    for (int col = 0; col < 5; ++col)
+      for (int row = 0; row < 8; ++row)
+        if (glyph[col] & (1 << row))
+          drawPixel(frame, i * 6 + col, row);
+  }
+}
+
+// ---------------------------
+// Blitter, what Display does
+// ---------------------------
+struct Blitter {
+  ScoreText scoreText;
+  GameState last{};
+  bool drawn = false;
+
+  void draw(uint8_t *frame, const GameState &state) {
+    if (drawn)
+      eraseSprite(frame, last.ball_x, last.ball_y, ballSprite);
+    scoreText.draw(frame, state.score);
+    blitSprite(frame, state.ball_x, state.ball_y, ballSprite);
+    last = state;
+    drawn = true;
+  }
+};
@@ -1,17 +1,156 @@
 #pragma once
 #include "com_interface.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
 #include <string>
+#include <thread>
+
+// Several I2C messages sent as one I2C_RDWR ioctl, with a repeated start
+// between them. The bytes are copied in, so the caller's buffers are free
+// again as soon as a message is added.
+class I2CTransaction {
+public:
+  static constexpr size_t maxMessages = 42; // I2C_RDWR_IOCTL_MAX_MSGS
+  static constexpr size_t maxBytes = 4096;
+
+  I2CTransaction &write(uint8_t address, const uint8_t *data, uint16_t length);
+  // The reply lands in dst when the transaction completes
+  I2CTransaction &read(uint8_t address, uint8_t *dst, uint16_t length);
+
+  // False if a message did not fit, submit() then fails
+  bool ok() const { return ok_; }
+  size_t messages() const { return count_; }
+  size_t bytes() const { return used_; }
+  bool fits(uint16_t length) const {
+    return count_ < maxMessages && used_ + length <= maxBytes;
+  }
+  void clear() { count_ = 0; used_ = 0; ok_ = true; }
+
+  // Message i, for buses that stand in for the device
+  uint8_t address(size_t i) const { return msg_[i].address; }
+  bool isRead(size_t i) const { return msg_[i].dst != nullptr; }
+  uint8_t *data(size_t i) { return buf_ + msg_[i].offset; }
+  uint16_t length(size_t i) const { return msg_[i].length; }
+
+private:
+  friend class I2CDriver;
+
+  struct Message {
+    uint16_t offset; // into buf_
+    uint16_t length;
+    uint8_t address;
+    uint8_t *dst;    // reads only
+  };
+
+  Message *add(uint8_t address, uint16_t length, uint8_t *dst);
+
+  Message msg_[maxMessages];
+  uint8_t buf_[maxBytes];
+  size_t count_ = 0;
+  size_t used_ = 0;
+  bool ok_ = true;
+};
+
+// Bus traffic of an I2CDriver. busNs is the time spent in transfers, which
+// on a real bus is mostly the bytes being clocked out.
+struct I2CStats {
+  uint64_t writes = 0;         // write() calls
+  uint64_t reads = 0;          // read() calls
+  uint64_t messages = 0;       // I2C messages (start, address, data)
+  uint64_t bytes = 0;          // data bytes, without address bytes
+  uint64_t syscalls = 0;       // ioctl, write and read calls
+  uint64_t addressChanges = 0; // I2C_SLAVE ioctls
+  uint64_t flushes = 0;        // batches sent
+  uint64_t errors = 0;
+  uint64_t busNs = 0;
+
+  double syscallsPerFlush() const { return flushes ? double(syscalls) / flushes : 0; }
+  double busUsPerFlush() const { return flushes ? busNs / 1000.0 / flushes : 0; }
+  void print(std::ostream &out) const;
+};
+
+// Outside a batch, write() and read() transfer at once; the slave address
+// is only set again (ioctl I2C_SLAVE) when it changes. Between beginBatch()
+// and flush() or flushAsync(), writes are queued and go out together in one
+// I2C_RDWR ioctl. flushAsync() hands the batch to a background thread, so
+// the caller can draw the next frame while this one is on the bus:
+//
+//   i2c.beginBatch();
+//   i2c.write(0x3C, cmds, 7);
+//   i2c.write(0x3C, data, 129);
+//   i2c.flushAsync([](int8_t result) { ... });
+//
+// A batch is filled by one thread at a time. A transfer started while an
+// async flush is running waits for it, so the bus sees everything in order.
 class I2CDriver : public SYSHAT::ICommInterface {
 public:
-  I2CDriver();
-  ~I2CDriver();
+  explicit I2CDriver(const char *i2c_device);
+  I2CDriver(const I2CDriver &) = delete;
+  I2CDriver &operator=(const I2CDriver &) = delete;
+  ~I2CDriver() override;
 
-  // Implement all pure virtual functions
+  virtual bool isOpen() const { return fd_ >= 0; }
+
+  // Queued inside a batch; a write that does not fit sends the batch so far first
   int8_t write(uint8_t slaveAddress, const uint8_t *buf,
-                uint16_t length) override;
+               uint16_t length) override;
 
+  // Sends a pending batch first, reads are never queued
   int8_t read(uint8_t slaveAddress, uint8_t *buf, uint16_t length) override;
 
+  void beginBatch();
+  // Sends the queued writes and returns the result
+  int8_t flush();
+  // Sends the queued writes on the flush thread and returns at once, after
+  // waiting for the previous async flush if it is still running. done gets
+  // the result on the flush thread.
+  void flushAsync(std::function<void(int8_t)> done = nullptr);
+  // Waits until no async flush is running
+  void waitIdle();
+
+  I2CStats stats() const;
+
+protected:
+  // No device, for subclasses that stand in for the bus. Their destructor
+  // calls waitIdle(), the flush thread may still be in their submit().
+  I2CDriver() = default;
+
+  // The bus operations, virtual so a simulated bus can stand in.
+  // submit sends all messages of t in one I2C_RDWR ioctl.
+  virtual int8_t submit(I2CTransaction &t);
+  virtual int8_t transmit(uint8_t address, const uint8_t *buf, uint16_t length);
+  virtual int8_t receive(uint8_t address, uint8_t *buf, uint16_t length);
+
+  // For the operations above: system calls they made
+  void countSyscalls(uint64_t syscalls, uint64_t addressChanges = 0);
+
+  // Copies the replies of a completed transaction to their destinations
+  static void finish(I2CTransaction &t);
+
 private:
   int fd_ = -1;
+  int address_ = -1; // slave address set on fd_, -1 if unknown
+
+  // pending is filled by the caller, the other slot is on the flush thread
+  I2CTransaction slots_[2];
+  int pending_ = 0;
+  bool batching_ = false;
+
+  std::thread flushThread_;
+  std::mutex mtx_;
+  std::condition_variable work_;
+  std::condition_variable idle_;
+  std::function<void(int8_t)> done_;
+  bool busy_ = false;
+  bool stopping_ = false;
+
+  mutable std::mutex statsMtx_;
+  I2CStats stats_;
+
+  int8_t send(I2CTransaction &t);
+  void flushLoop();
 };
@@ -1,19 +1,73 @@
 #pragma once
 #include <com_interface.hpp>
 #include <linux/spi/spidev.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string>
 
+// Several register accesses submitted as one SPI_IOC_MESSAGE(N) ioctl.
+// Chip select is released between segments, so each one is a separate
+// register access to the device. All buffers live inside the object, build
+// it on the stack:
+//
+//   SPITransaction t;
+//   t.readReg(STATUS, &status, 1).readReg(DATA, data, 6);
+//   spi.submit(t);
+class SPITransaction {
+public:
+  static constexpr size_t maxSegments = 8;
+  static constexpr size_t maxBytes = 1280; // room for a full BMI160 FIFO burst
+
+  // Register read: sends reg | 0x80, the reply lands in dst after submit()
+  SPITransaction &readReg(uint8_t reg, uint8_t *dst, uint16_t length);
+
+  // Register write: sends reg followed by the data
+  SPITransaction &writeReg(uint8_t reg, const uint8_t *data, uint16_t length);
+  SPITransaction &writeReg(uint8_t reg, uint8_t value) { return writeReg(reg, &value, 1); }
+
+  // Raw segment: `length` bytes out of tx (or zeros), the reply into rx
+  SPITransaction &transfer(const uint8_t *tx, uint8_t *rx, uint16_t length);
+
+  // False if a segment did not fit, submit() then fails
+  bool ok() const { return ok_; }
+  size_t segments() const { return count_; }
+  void clear() { count_ = 0; used_ = 0; ok_ = true; }
+
+  // Bytes on the wire of segment i; a bus overwrites them with the reply
+  uint8_t *data(size_t i) { return buf_ + seg_[i].offset; }
+  uint16_t length(size_t i) const { return seg_[i].length; }
+
+private:
+  friend class SPIDriver;
+
+  struct Segment {
+    uint16_t offset;  // into buf_, including the address byte if any
+    uint16_t length;  // total bytes on the wire
+    uint16_t skip;    // leading reply bytes that are not data (address)
+    uint8_t *dst;     // where the reply goes, or nullptr
+  };
+
+  Segment *add(uint16_t length, uint16_t skip, uint8_t *dst);
+
+  Segment seg_[maxSegments];
+  uint8_t buf_[maxBytes];
+  size_t count_ = 0;
+  size_t used_ = 0;
+  bool ok_ = true;
+};
+
 class SPIDriver : public SYSHAT::ICommInterface {
 public:
   SPIDriver(const char *spi_device);
-  SPIDriver(SPIDriver &&) = default;
-  SPIDriver(const SPIDriver &) = default;
-  SPIDriver &operator=(SPIDriver &&) = default;
-  SPIDriver &operator=(const SPIDriver &) = default;
+  SPIDriver(SPIDriver &&other) noexcept;
+  SPIDriver(const SPIDriver &) = delete;
+  SPIDriver &operator=(SPIDriver &&other) noexcept;
+  SPIDriver &operator=(const SPIDriver &) = delete;
   ~SPIDriver();
 
-  // read and write
+  virtual bool isOpen() const { return fd_ >= 0; }
+
+  // read and write (slaveAddress is the register address, sent as is)
   int8_t write(uint8_t slaveAddress, const uint8_t *buf,
                uint16_t length) override;
 
@@ -22,8 +76,18 @@ public:
   int8_t transfer(const uint8_t *tx_buffer, uint8_t *rx_buffer,
                   uint16_t length);
 
+  // Runs all segments of t in one ioctl and copies the replies out.
+  // Virtual so a simulated device can stand in for the bus.
+  virtual int8_t submit(SPITransaction &t);
+
   void spi_delayMicroseconds(uint32_t ms);
 
+protected:
+  SPIDriver() = default; // no device, for subclasses that override submit()
+
+  // Copies the replies of a completed transaction to their destinations
+  static void finish(SPITransaction &t);
+
 private:
   int fd_ = -1;
   uint32_t speed_ = 1000000; // 1MHz
@@ -1,33 +1,99 @@
 #pragma once
-#include <linux/spi/spidev.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include "SPIdriver.hpp"
 #include "message.hpp"
+#include "event_source.hpp"
+#include "orientation_filter.hpp"
+#include "sample_decode.hpp"
 
 // For acceleration
 #define BMI160_ACCEL_REG      0x12
 #define BMI160_ACCEL_SENS     16384.0   // for ±2g
+// Gyro data sits right before the accelerometer's, 0x0C..0x17 is one burst
+#define BMI160_GYRO_REG       0x0C
+#define BMI160_GYRO_SENS      16.4      // for ±2000 degrees/s
+#define BMI160_GYR_CONF_REG   0x42
 #define BMI160_CMD_REG 0x7E
 #define BMI160_CHIP_ID_REG 0x00
 #define BMI160_STATUS_REG 0x1B
 #define BMI160_READ_BIT 0x80
-#define SPI_SPEED 1000000 // 1 MHz
-#define SPI_BITS_PER_WORD 8
 #define MAXBUFSIZE 32
 
+// FIFO (datasheet p.28 and p.60)
+#define BMI160_FIFO_LENGTH_REG 0x22 // 11 bit fill level in bytes, 2 registers
+#define BMI160_FIFO_DATA_REG   0x24
+#define BMI160_ACC_CONF_REG    0x40
+#define BMI160_FIFO_CONFIG_0   0x46 // watermark in units of 4 bytes
+#define BMI160_FIFO_CONFIG_1   0x47
+#define BMI160_FIFO_ACC_EN     0x40 // headerless, accelerometer frames only
+#define BMI160_FIFO_GYR_EN     0x80 // gyro frames, stored before the accelerometer's
+#define BMI160_FIFO_FLUSH      0xB0 // command
+#define BMI160_FIFO_SIZE       1024
+#define BMI160_ACCEL_FRAME     6    // x, y, z as int16
+#define BMI160_GYRO_FRAME      6
+#define BMI160_FIFO_MAX_FRAMES (BMI160_FIFO_SIZE / BMI160_ACCEL_FRAME)
+
+// Interrupts (datasheet p.62)
+#define BMI160_INT_EN_1        0x51
+#define BMI160_INT_OUT_CTRL    0x53
+#define BMI160_INT_MAP_1       0x56
+#define BMI160_INT1_PUSH_PULL_HIGH 0x0A // output enabled, active high
+#define BMI160_INT_DRDY        0x10 // INT_EN_1 data ready
+#define BMI160_INT_FWM         0x40 // INT_EN_1 FIFO watermark
+#define BMI160_INT1_MAP_DRDY   0x80
+#define BMI160_INT1_MAP_FWM    0x40
+
+enum class AccelMode {
+    Polling, // read the data registers whenever the status register says so
+    Fifo     // let the sensor buffer samples and drain them in one burst
+};
+
 class Accelerometer
 {
-    bool isActive;
-    int fd;
-    int buffer[MAXBUFSIZE] = {0};
-    struct spi_ioc_transfer tx[1] = {0};
-    void initSPI(std::string path_name);
+    std::atomic<bool> isActive;
+    SPIDriver &spi;
+    alignas(16) uint8_t buffer[MAXBUFSIZE] = {0};
+    alignas(16) uint8_t fifo[BMI160_FIFO_SIZE] = {0};
+    // Decoded frames, x/y/z rows in g and degrees/s
+    float accelSamples[3][BMI160_FIFO_MAX_FRAMES] = {};
+    float gyroSamples[3][BMI160_FIFO_MAX_FRAMES] = {};
+
+    AccelMode mode;
+    int odrHz;            // output data rate
+    int watermarkFrames;  // FIFO is drained once this many samples are buffered
+    bool fusion;          // read the gyro too and publish orientation
+    ComplementaryFilter filter;
+    uint64_t fifoOverruns = 0;
+    std::unique_ptr<EventSource> events; // wakes the thread when data is ready
+
     int readReg(uint8_t reg, uint8_t nbytes);
     int writeReg(uint8_t reg, uint8_t data);
+    int readBurst(uint8_t reg, uint16_t nbytes);
     void startAccel(void);
-    bool isAccelDataAvailable(void);
-    void readAccel(void);
+    void startFifo(void);
+    void startInterrupt(void);
+    int readFifo(void);
+    int frameBytes() const { return fusion ? BMI160_GYRO_FRAME + BMI160_ACCEL_FRAME : BMI160_ACCEL_FRAME; }
+
+    void decode(const uint8_t *frames, int count);
+    void publishSample(int i, std::chrono::steady_clock::time_point timestamp);
+    void pollingLoop();
+    void fifoLoop();
 
     public:
-        explicit Accelerometer(std::string path_name);
+        // odrHz is rounded to the nearest supported rate (25 Hz .. 1600 Hz).
+        // With fusion every sample also feeds a ComplementaryFilter and
+        // the thread publishes the orientation topic next to accl.
+        explicit Accelerometer(SPIDriver &spi, AccelMode mode = AccelMode::Fifo,
+                               int odrHz = 400, int watermarkFrames = 8, bool fusion = true);
         ~Accelerometer();
         void accelerometerThread();
+        void stop() { isActive = false; } // accelerometerThread returns within ~100 ms
+
+        // What the thread waits on, e.g. a GpioLineEvent on the pin wired
+        // to INT1. Without one it samples on a timer (TimerEvent).
+        void setEventSource(std::unique_ptr<EventSource> source) { events = std::move(source); }
     };
@@ -9,8 +9,8 @@
  * (31,0)..........................(31,127)
  */
 
-// 8x8 ball bitmap
-const uint8_t ballBitmap[] = {
+// 8x8 ball bitmap, one byte per row
+constexpr uint8_t ballBitmap[] = {
     0x3C, // ..####..
     0x7E, // .######.
     0xDB, // ##.##.##
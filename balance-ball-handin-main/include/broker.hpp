@@ -10,19 +10,90 @@
 #include <queue>
 #include <memory>
 #include <chrono>
+#include <atomic>
+#include <deque>
+#include <string_view>
 #include "message.hpp"
+#include "message_pool.hpp"
 #include "iconsumer.hpp"
+#include "dispatcher.hpp"
+#include "broker_metrics.hpp"
+#include "topics.hpp"
+#include "topic_trie.hpp"
+
+// ------------------------------
+// Subscription
+// ------------------------------
+// Sync subscriptions have no dispatcher and are delivered on the publisher's
+// thread. Async subscriptions of one consumer with the same options share a
+// Dispatcher, i.e. one delivery thread with a high and a normal priority
+// lane. Different options get a dispatcher of their own, so onMessage may
+// then run on more than one thread.
+struct Subscription {
+    std::weak_ptr<IConsumer> consumer;
+    std::shared_ptr<Dispatcher> dispatcher;
+    uint32_t metricsId = BrokerMetrics::noConsumer;
+};
+
+// ------------------------------
+// SubscriberTable
+// ------------------------------
+// Immutable snapshot of all subscriptions. Writers copy the current table,
+// modify the copy and swap it in (read-copy-update); publishers only read.
+// Wildcard patterns are matched once, when a subscription or topic is added,
+// and the result is cached per concrete topic id.
+struct SubscriberTable {
+    TopicTrie<Subscription> patterns;                   // subscriptions as subscribed
+    std::vector<std::string_view> names;                // indexed by topic id
+    std::vector<Priority> priorities;                   // indexed by topic id
+    std::vector<std::vector<Subscription>> subscribers; // resolved, indexed by topic id
+
+    void resolve(TopicId topic);
+    void resolveAll();
+};
 
 // ------------------------------
 // Broker (Thread-Safe Singleton)
 // ------------------------------
+// publish() reads the current SubscriberTable without locks or allocations.
+// Old tables are freed by a background thread once no publisher can still
+// be reading them; the same thread prunes expired subscribers.
 class Broker {
 private:
-    std::map<std::string, std::vector<std::weak_ptr<IConsumer>>> subscribers;
-    std::mutex mtx;
-    Broker() = default;
+    std::atomic<const SubscriberTable*> table;
+    std::mutex mtx;                              // serializes writers only
+    std::vector<const SubscriberTable*> retired; // guarded by mtx
+    std::deque<std::string> topicNames;          // storage of runtime topic names, guarded by mtx
+
+    // Readers register in the counter of the current epoch. A grace period
+    // flips the epoch and waits for the old counter to drain (twice).
+    std::atomic<uint32_t> epoch{0};
+    std::atomic<uint32_t> readers[2] = {0, 0};
+
+    std::atomic<bool> running{true};
+    std::atomic<bool> pruneRequested{false};
+    std::atomic<uint32_t> janitorSignal{0};
+    std::thread janitor;
+
+    // Periodic metrics dump, see reportMetrics()
+    std::thread reporter;
+    std::mutex reporterMtx;
+    std::condition_variable reporterCv;
+    bool reporting = false; // guarded by reporterMtx
+
+    Broker();
+
+    uint32_t readLock();
+    void readUnlock(uint32_t e);
+    void update(const std::function<void(SubscriberTable&)> &modify);
+    void waitForReaders();
+    void janitorThread();
+    void wakeJanitor();
+    void stopReporter();
 
 public:
+    static constexpr TopicId invalidTopic = 0xFFFF;
+
     Broker(const Broker&) = delete;
     Broker& operator=(const Broker&) = delete;
 
@@ -31,11 +102,68 @@ public:
         return instance;
     }
 
-    void subscribe(const std::string &topic, std::shared_ptr<IConsumer> IConsumer);
+    ~Broker();
+
+    // Pattern may be a topic name or use wildcards, e.g. "sensor/#", "input/btn/+"
+    void subscribe(std::string_view pattern, std::shared_ptr<IConsumer> IConsumer,
+                   const SubscriptionOptions &options = {});
+
+    void unsubscribe(std::string_view pattern, std::shared_ptr<IConsumer> IConsumer);
+
+    template <typename Payload>
+    void subscribe(const Topic<Payload> &topic, std::shared_ptr<IConsumer> IConsumer,
+                   const SubscriptionOptions &options = {}) {
+        subscribe(topic.name, std::move(IConsumer), options);
+    }
+
+    template <typename Payload>
+    void unsubscribe(const Topic<Payload> &topic, std::shared_ptr<IConsumer> IConsumer) {
+        unsubscribe(topic.name, std::move(IConsumer));
+    }
+
+    // Adds a concrete topic at runtime (or looks up an existing one) and
+    // resolves the wildcard subscriptions that match it
+    TopicId registerTopic(std::string_view name, Priority priority = Priority::Normal);
+
+    template <typename Payload>
+    Topic<Payload> registerTopic(std::string_view name, Priority priority = Priority::Normal) {
+        TopicId id = registerTopic(name, priority);
+        return Topic<Payload>{id, topicName(id)};
+    }
+
+    void setPriority(TopicId topic, Priority priority);
+
+    std::string_view topicName(TopicId topic);
+
+    void publish(MessagePtr msg);
+
+    template <typename Payload>
+    void publish(const Topic<Payload> &topic, const Payload &payload) {
+        publish(makeMessage(topic.id, payload));
+    }
+
+    // Queue depth and drop counters of an async subscription (zeros if sync)
+    SubscriptionStats stats(std::string_view pattern, std::shared_ptr<IConsumer> IConsumer);
+
+    template <typename Payload>
+    SubscriptionStats stats(const Topic<Payload> &topic, std::shared_ptr<IConsumer> IConsumer) {
+        return stats(topic.name, std::move(IConsumer));
+    }
+
+    // Subscriptions a publish to topic goes to, expired ones until pruned
+    std::size_t subscriberCount(TopicId topic);
+
+    template <typename Payload>
+    std::size_t subscriberCount(const Topic<Payload> &topic) {
+        return subscriberCount(topic.id);
+    }
 
-    void unsubscribe(const std::string &topic, std::shared_ptr<IConsumer> IConsumer);
+    // Per-topic and per-consumer counters and latency histograms
+    MetricsSnapshot metrics();
 
-    void publish(std::unique_ptr<Message> msg);
+    // Prints metrics() to `out` every `interval` from a background thread,
+    // a zero interval stops it
+    void reportMetrics(std::chrono::milliseconds interval, std::ostream &out = std::cerr);
 
     // void subscribe(const std::string& topic, std::shared_ptr<IConsumer> IConsumer) {
     //     std::lock_guard<std::mutex> lock(mtx);
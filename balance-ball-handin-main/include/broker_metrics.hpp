@@ -0,0 +1,189 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "iconsumer.hpp"
+#include "message.hpp"
+#include "topics.hpp"
+
+// ---------------------------
+// HistogramSnapshot
+// ---------------------------
+// Log-linear buckets in the style of HdrHistogram: values below 8 get a
+// bucket each, above that every power of two is split into 8 sub-buckets,
+// so a reported value is within 12.5% of the recorded one. Values are
+// nanoseconds and are clamped at 2^40 (~18 minutes).
+struct HistogramSnapshot {
+    static constexpr int subBits = 3;
+    static constexpr int subBuckets = 1 << subBits;
+    static constexpr int maxBits = 40;
+    static constexpr int buckets = (maxBits - subBits + 1) * subBuckets;
+
+    std::array<uint64_t, buckets> counts{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    static int bucketOf(uint64_t ns);
+    static uint64_t lowerBound(int bucket);
+
+    void merge(const HistogramSnapshot &other);
+    uint64_t percentile(double p) const; // highest value of the bucket holding p (0..1)
+    uint64_t mean() const { return count ? sum / count : 0; }
+};
+
+// One writer thread, any number of readers
+class LatencyHistogram {
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::buckets> counts{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+
+public:
+    void record(uint64_t ns);
+    void addTo(HistogramSnapshot &out) const;
+};
+
+// ---------------------------
+// Snapshot
+// ---------------------------
+struct TopicMetrics {
+    TopicId topic = 0;
+    std::string_view name;
+    uint64_t published = 0;
+    uint64_t delivered = 0; // onMessage calls, one per subscriber
+    uint64_t dropped = 0;   // overflow policy discarded the message
+    uint64_t coalesced = 0; // Latest mode overwrote the message
+    uint64_t expired = 0;   // subscriber's consumer was already destroyed
+    uint64_t unrouted = 0;  // published without any subscriber
+    HistogramSnapshot dispatchLatency; // publish -> start of onMessage
+};
+
+struct ConsumerMetrics {
+    uint32_t id = 0;
+    std::string name;
+    uint64_t delivered = 0;
+    HistogramSnapshot onMessage; // time spent inside onMessage
+};
+
+struct MetricsSnapshot {
+    std::vector<TopicMetrics> topics;
+    std::vector<ConsumerMetrics> consumers;
+
+    void print(std::ostream &out) const;
+};
+
+// ---------------------------
+// BrokerMetrics
+// ---------------------------
+// Every thread that publishes or delivers writes to its own shard, so the
+// hot path is a handful of relaxed stores to cache lines no other thread
+// writes. snapshot() merges the shards. A shard outlives its thread and is
+// handed to the next new thread, so counts are never lost.
+// Only the first maxIds topic and consumer ids are tracked.
+class BrokerMetrics {
+public:
+    static constexpr uint32_t maxIds = 4096;
+
+private:
+    struct TopicCounters {
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> coalesced{0};
+        std::atomic<uint64_t> expired{0};
+        std::atomic<uint64_t> unrouted{0};
+        LatencyHistogram dispatchLatency;
+    };
+
+    struct ConsumerCounters {
+        std::atomic<uint64_t> delivered{0};
+        LatencyHistogram onMessage;
+    };
+
+    // Counters are allocated a page at a time by the owning thread
+    template <typename T>
+    class PagedTable {
+        static constexpr uint32_t pageSize = 8;
+        std::array<std::atomic<T*>, maxIds / pageSize> pages{};
+
+    public:
+        ~PagedTable() {
+            for (auto &page : pages)
+                delete[] page.load();
+        }
+
+        T *at(uint32_t id) {
+            if (id >= maxIds)
+                return nullptr;
+            T *page = pages[id / pageSize].load(std::memory_order_acquire);
+            if (!page) {
+                page = new T[pageSize];
+                pages[id / pageSize].store(page, std::memory_order_release);
+            }
+            return &page[id % pageSize];
+        }
+
+        const T *find(uint32_t id) const {
+            const T *page = pages[id / pageSize].load(std::memory_order_acquire);
+            return page ? &page[id % pageSize] : nullptr;
+        }
+    };
+
+    struct Shard {
+        PagedTable<TopicCounters> topics;
+        PagedTable<ConsumerCounters> consumers;
+        std::atomic<bool> inUse{true};
+    };
+
+    std::mutex mtx;
+    std::deque<Shard> shards;                // guarded by mtx, addresses are stable
+    std::vector<std::string> consumerNames;  // guarded by mtx, indexed by consumer id
+    std::atomic<bool> enabled{true};
+
+    BrokerMetrics() = default;
+
+    Shard &local();
+    Shard *acquireShard();
+    TopicCounters *topic(TopicId id) { return local().topics.at(id); }
+
+public:
+    static constexpr uint32_t noConsumer = 0xFFFFFFFF;
+
+    BrokerMetrics(const BrokerMetrics&) = delete;
+    BrokerMetrics& operator=(const BrokerMetrics&) = delete;
+
+    // Never destroyed: detached delivery threads may record during exit
+    static BrokerMetrics& getInstance() {
+        static BrokerMetrics *instance = new BrokerMetrics();
+        return *instance;
+    }
+
+    void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Returns the id under which a consumer's onMessage time is recorded,
+    // the consumer shows up in snapshots under its class name
+    uint32_t registerConsumer(const IConsumer &consumer);
+
+    void published(TopicId topic);
+    void unrouted(TopicId topic);
+    void dropped(TopicId topic);
+    void coalesced(TopicId topic);
+    void expired(TopicId topic);
+
+    // Calls consumer.onMessage(msg), recording the time the message waited
+    // since it was created and the time onMessage took
+    void deliver(IConsumer &consumer, const Message &msg, uint32_t consumerId);
+
+    // Merged counters of topic ids below topicCount and of all consumers
+    // (topic names are left empty, Broker::metrics() fills them in)
+    MetricsSnapshot snapshot(std::size_t topicCount);
+};
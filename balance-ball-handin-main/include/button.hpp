@@ -1,14 +1,68 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
 #include "message.hpp"
+#include "topics.hpp"
 
+// ---------------------------
+// Button
+// ---------------------------
+// One button input: owns the device node's file descriptor and debounces
+// the levels read from it. The first change is published at once, further
+// changes are ignored until the contacts have had `debounce` to settle;
+// if the level then differs from the published one it is published too.
+// So a press costs no extra latency and only state changes go out.
+// Buttons are read by an InputThread, which waits on all of them at once;
+// one whose driver can't be polled is read by readLoop() instead.
 class Button
 {
-    bool isActive;
-    int fd;
-    int gpio;
-
 public:
-    explicit Button(std::string path_name, int gpio);
+    using Clock = std::chrono::steady_clock;
+
+    Button(const std::string &path_name, int gpio, Topic<ButtonData> topic = topics::btn,
+           std::chrono::milliseconds debounce = std::chrono::milliseconds(20));
+    // Takes over an open fd, e.g. the read end of a pipe in a test
+    Button(int fd, int gpio, Topic<ButtonData> topic = topics::btn,
+           std::chrono::milliseconds debounce = std::chrono::milliseconds(20));
     ~Button();
-    void ButtonThread();
+
+    Button(const Button&) = delete;
+    Button& operator=(const Button&) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+    int getFd() const { return fd; }
+    int getGpio() const { return gpio; }
+
+    // Reads what the driver has ('0'/'1' or raw 0/1 bytes, each one an
+    // edge at `now`). Returns the number of levels read, -1 once the
+    // device is gone (EOF or error).
+    int readInput(Clock::time_point now);
+
+    // Publishes a level that changed during the debounce window, once
+    // the window is over
+    void settle(Clock::time_point now);
+
+    // When settle() next has work to do, Clock::time_point::max() if none
+    Clock::time_point deadline() const;
+
+    // Fallback for drivers without poll support: reads the button every
+    // `period` on the calling thread until stop() or the device is gone
+    void readLoop(std::chrono::milliseconds period = std::chrono::milliseconds(10));
+    void stop() { isActive = false; }
+
+private:
+    int fd = -1;
+    int gpio;
+    std::atomic<bool> isActive{true};
+    TopicId topic;
+    Clock::duration debounce;
+
+    int raw = -1;       // last level read
+    int published = -1; // last level published, -1 before the first read
+    bool settling = false;
+    Clock::time_point quietAt{}; // end of the debounce window
+
+    void onLevel(int level, Clock::time_point now);
+    void publish(int level, Clock::time_point timestamp);
 };
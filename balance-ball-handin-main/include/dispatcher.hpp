@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include "mailbox.hpp"
+#include "message.hpp"
+#include "message_pool.hpp"
+#include "iconsumer.hpp"
+#include "topics.hpp"
+#include "broker_metrics.hpp"
+
+// ---------------------------
+// Subscription options
+// ---------------------------
+enum class DeliveryMode {
+    Sync,   // onMessage runs on the publisher's thread (default)
+    Async,  // publish enqueues, a per-consumer thread calls onMessage
+    Latest  // like Async, but a slot per topic holds only its newest message
+};
+
+enum class OverflowPolicy {
+    Block,      // publisher waits for a free slot
+    DropOldest, // discard the oldest queued message
+    DropNewest  // discard the message being published
+};
+
+struct SubscriptionOptions {
+    DeliveryMode mode = DeliveryMode::Sync;
+    std::size_t queueDepth = 64;
+    OverflowPolicy overflow = OverflowPolicy::Block;
+
+    bool operator==(const SubscriptionOptions&) const = default;
+};
+
+struct SubscriptionStats {
+    std::size_t queued = 0;
+    std::size_t capacity = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t coalesced = 0; // Latest mode: updates overwritten before delivery
+
+    // Time high priority messages waited between publish and delivery
+    uint64_t highDelivered = 0;
+    uint64_t highWaitTotalNs = 0;
+    uint64_t highWaitMaxNs = 0;
+};
+
+// ---------------------------
+// Dispatcher (one per async consumer and options)
+// ---------------------------
+// Owns the consumer's mailboxes and the thread that drains them. There are
+// two lanes: high priority messages are always taken before normal ones.
+// In Latest mode the normal lane is an atomic slot per topic that post()
+// overwrites, so a slow consumer always gets the newest value of each
+// topic and never a backlog; the full slots are delivered round robin.
+// The high lane is always a queue so control events are not lost.
+// The thread keeps the dispatcher alive until stop() is called, so a
+// consumer may unsubscribe itself from inside its own onMessage.
+class Dispatcher : public std::enable_shared_from_this<Dispatcher> {
+    // Latest mode slots of 64 topics, each owns one reference
+    struct LatestSlots {
+        std::atomic<const Message*> slot[64] = {};
+    };
+    static constexpr std::size_t latestGroups = (std::size_t(TopicId(-1)) + 1) / 64;
+
+    std::weak_ptr<IConsumer> consumer;
+    uint32_t metricsId;
+    SubscriptionOptions options;
+    bool conflate;
+    Mailbox<MessageRef> urgent;  // high priority lane
+    Mailbox<MessageRef> mailbox; // normal priority lane
+    // Latest mode: slots are allocated 64 topics at a time on first use, a
+    // bit per topic marks the full ones
+    std::unique_ptr<std::atomic<LatestSlots*>[]> latest;
+    std::unique_ptr<std::atomic<uint64_t>[]> latestReady;
+    std::atomic<std::size_t> latestUsed{0}; // groups that may have slots
+    std::size_t latestNext = 0;             // delivery thread only, topic to look at first
+    std::atomic<bool> running{true};
+    std::atomic<uint32_t> pushed{0}; // bumped after every push, waited on by the thread
+    std::atomic<uint32_t> popped{0}; // bumped after every pop, waited on by blocked publishers
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<uint64_t> highDelivered{0};
+    std::atomic<uint64_t> highWaitTotalNs{0};
+    std::atomic<uint64_t> highWaitMaxNs{0};
+
+    void enqueue(Mailbox<MessageRef> &lane, MessageRef msg);
+    LatestSlots *latestSlots(TopicId topic);
+    bool takeLatest(MessageRef &msg);
+    bool take(MessageRef &msg);
+    void deliveryThread();
+
+public:
+    Dispatcher(std::weak_ptr<IConsumer> consumer, const SubscriptionOptions &options,
+               uint32_t metricsId = BrokerMetrics::noConsumer);
+
+    ~Dispatcher();
+
+    Dispatcher(const Dispatcher&) = delete;
+    Dispatcher& operator=(const Dispatcher&) = delete;
+
+    void start();
+    void stop();
+    void post(MessageRef msg, Priority priority = Priority::Normal);
+    SubscriptionStats stats() const;
+
+    // Whether a subscription with these options can share this dispatcher
+    bool accepts(const SubscriptionOptions &other) const { return other == options; }
+};
@@ -1,15 +1,72 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
 #include <mutex>
-#include "SSD1306_OLED.hpp"
+#include "I2Cdriver.hpp"
 #include "iconsumer.hpp"
 #include "game_state.hpp"
+#include "sprite.hpp"
 
+// SSD1306 I2C control bytes and commands (datasheet p.20 and p.34)
+#define SSD1306_CONTROL_CMD   0x00
+#define SSD1306_CONTROL_DATA  0x40
+#define SSD1306_MEMORY_MODE   0x20 // 0x00: horizontal addressing
+#define SSD1306_COLUMN_ADDR   0x21 // start, end column
+#define SSD1306_PAGE_ADDR     0x22 // start, end page
+
+// Bus traffic of Display, bytes include I2C control and command bytes
+struct DisplayStats {
+    uint64_t frames = 0;
+    uint64_t unchanged = 0; // frames that sent nothing
+    uint64_t partial = 0;   // frames sent as one or more windows
+    uint64_t full = 0;      // frames sent whole
+    uint64_t bytes = 0;
+    uint64_t writes = 0;    // I2C transfers
+    uint32_t lastFrameBytes = 0;
+
+    double bytesPerFrame() const { return frames ? double(bytes) / frames : 0; }
+    void print(std::ostream &out) const;
+};
+
+// ---------------------------
+// Display
+// ---------------------------
+// Draws the game straight into the page buffer: the ball is erased where it
+// was and blitted pre-shifted where it is, the score text comes from a
+// cache. Then sends only what changed since the last transmitted frame. A
+// shadow copy of that frame gives each page's changed column span; the
+// spans go out as SSD1306 column/page address windows, or as their bounding
+// box or the whole screen if that is fewer bytes. A frame's writes go out
+// as one batch on the driver's flush thread, the next frame is drawn
+// meanwhile.
 class Display
 {
 public:
-    explicit Display(SSD1306 &oledRef);
+    // buffer is an OLED_BUFFER_SIZE page buffer, e.g. the one registered
+    // with the OLED library. bus is the real I2C bus or a SimSSD1306.
+    Display(I2CDriver &bus, uint8_t *buffer, uint8_t address = 0x3C);
+    ~Display();
     void drawDisplay(GameState gameState);
+
+    DisplayStats stats();
+
 private:
-    SSD1306 &oled;
+    I2CDriver &bus;
+    uint8_t *buffer;
+    uint8_t address;
     std::mutex display_mtx;
+
+    ScoreText scoreText;
+    int ballX = 0, ballY = 0; // where the ball is in the buffer
+    bool ballDrawn = false;
+
+    uint8_t shadow[OLED_BUFFER_SIZE] = {0}; // what the panel shows
+    bool shadowValid = false;               // false: send the whole frame
+    std::atomic<bool> sendFailed{false};    // set by the flush thread
+    DisplayStats counters;
+
+    void flush();
+    bool sendWindow(int firstPage, int lastPage, int firstColumn, int lastColumn);
+    bool command(const uint8_t *cmds, uint16_t length);
 };
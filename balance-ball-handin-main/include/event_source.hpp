@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// ---------------------------
+// EventSource
+// ---------------------------
+// Something a thread can sleep on until there is work: an interrupt pin, a
+// periodic timer or a counter bumped by software. Every source is a single
+// file descriptor, so it also works with poll/epoll directly via fd().
+class EventSource {
+protected:
+    int fd_ = -1;
+
+    // Reads the pending events off fd_, returns how many (or -1)
+    virtual int consume() = 0;
+
+public:
+    EventSource() = default;
+    virtual ~EventSource();
+
+    EventSource(const EventSource&) = delete;
+    EventSource& operator=(const EventSource&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+
+    // Blocks until at least one event or the timeout (-1 waits forever).
+    // Returns the number of events, 0 on timeout, -1 on error.
+    int wait(int timeoutMs);
+};
+
+// Rising edges of a GPIO line, e.g. the BMI160 INT1 pin
+// (character device API, /dev/gpiochipN)
+class GpioLineEvent : public EventSource {
+protected:
+    int consume() override;
+
+public:
+    GpioLineEvent(const std::string &chip, unsigned line);
+};
+
+// Fallback when no interrupt line is wired: fires every `period`
+class TimerEvent : public EventSource {
+protected:
+    int consume() override;
+
+public:
+    explicit TimerEvent(std::chrono::nanoseconds period);
+};
+
+// Fired from software with signal(), for tests and simulations
+class ManualEvent : public EventSource {
+protected:
+    int consume() override;
+
+public:
+    ManualEvent();
+    void signal(uint64_t events = 1);
+
+    // Another source waiting on the same counter (a dup of the eventfd), so
+    // the signalling side and the waiting side can be owned separately
+    std::unique_ptr<EventSource> listener() const;
+};
@@ -1,17 +1,51 @@
 #pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include "SSD1306_OLED.hpp"
 #include "iconsumer.hpp"
-#include "display.hpp"
+#include "event_source.hpp"
+#include "renderer.hpp"
 #include "game_state.hpp"
 
+// ---------------------------
+// GameControl
+// ---------------------------
+// Orientation messages only update the latest tilt. The ball moves on a
+// physics thread woken by a timerfd every 1/tickHz seconds: each step
+// integrates the tilt into velocity and the velocity into position over the
+// fixed step, and accrues the score by time. The game therefore runs at the
+// same speed whatever rate the sensor publishes at, and the same tilts give
+// the same game. Every step hands the Renderer the ball before and after the
+// step to interpolate between.
 class GameControl : public IConsumer
 {
-    Display *display;
-    GameState gameState;
-    void handleAccelerometer(const std::string& data);
-    void handleButton(const std::string& data);
+    Renderer *renderer;
+    std::mutex state_mtx; // physics thread and handlers, also serializes submit()
+
+    // Gravity along the board axes in g, from the latest orientation
+    double tiltX = 0, tiltY = 0;
+
+    // Ball in pixels and pixels/s, score with its fraction
+    double x, y, vx = 0, vy = 0;
+    double prevX, prevY;
+    double score = 0;
+    bool inside = true;
+
+    std::chrono::nanoseconds step;
+    TimerEvent tick;
+    std::atomic<bool> isActive{true};
+    std::thread physicsThread;
+
+    void physicsLoop();
+    // Advances the game by one step, returns the boundary state changed
+    bool stepPhysics();
+    void submit(int64_t stepTimeNs, int64_t stepNs);
 
 public:
-    explicit GameControl(Display& display);
-    void onMessage(const Message &msg) override;
+    explicit GameControl(Renderer& renderer, int tickHz = 200);
+    ~GameControl();
+
+    void onOrientation(const OrientationData &data) override;
+    void onButton(const ButtonData &data) override;
 };
@@ -1,7 +1,33 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 struct GameState {
     int ball_x;
     int ball_y;
     int score;
 };
+
+// ---------------------------
+// GameFrame
+// ---------------------------
+// What a physics step hands to the Renderer: the ball before and after the
+// step. Drawn a fraction of a step after the step was taken, the ball is
+// placed that fraction of the way between the two, so it moves smoothly at
+// any frame rate, one step behind the physics.
+struct GameFrame {
+    float prevX, prevY; // before the step
+    float x, y;         // after the step
+    int score;
+    int64_t stepTimeNs; // steady_clock time of the step
+    int64_t stepNs;     // step length, 0 draws (x, y)
+
+    GameState at(int64_t nowNs) const {
+        float alpha = 1;
+        if (stepNs > 0)
+            alpha = std::clamp(float(nowNs - stepTimeNs) / float(stepNs), 0.0f, 1.0f);
+        return {int(std::lround(prevX + (x - prevX) * alpha)), int(std::lround(prevY + (y - prevY) * alpha)),
+                score};
+    }
+};
@@ -1,5 +1,7 @@
 #pragma once
+#include <array>
 #include "message.hpp"
+#include "topics.hpp"
 
 // ---------------------------
 // IConsumer
@@ -8,8 +10,31 @@ class IConsumer {
 public:
 //    IConsumer(std::string n) : name(std::move(n)) {}
     virtual ~IConsumer() {}
-    virtual void onMessage(const Message &msg) = 0;
-    // void onMessage(const Message& msg) {
-    //     std::cout << "[IConsumer " << name << "] received data on topic " << msg.topic << "\n";
-    // }
+
+    // Called by the Broker. The default calls the typed handler of the
+    // payload, override to see every message as-is.
+    virtual void onMessage(const Message &msg);
+
+    // Typed handlers, one per payload type. Several topics may share a
+    // payload type (e.g. "input/btn/27" and "input/btn/17").
+    virtual void onAccelerometer(const AccelerometerData &) {}
+    virtual void onButton(const ButtonData &) {}
+    virtual void onBoundary(const BoundaryData &) {}
+    virtual void onOrientation(const OrientationData &) {}
 };
+
+inline void IConsumer::onMessage(const Message &msg)
+{
+    using Handler = void (*)(IConsumer &, const Message &);
+
+    // Indexed by payload type, same order as the Payload variant
+    static constexpr std::array<Handler, std::variant_size_v<Payload>> dispatch = {
+        [](IConsumer &, const Message &) {},
+        [](IConsumer &c, const Message &m) { c.onAccelerometer(*m.get<AccelerometerData>()); },
+        [](IConsumer &c, const Message &m) { c.onButton(*m.get<ButtonData>()); },
+        [](IConsumer &c, const Message &m) { c.onBoundary(*m.get<BoundaryData>()); },
+        [](IConsumer &c, const Message &m) { c.onOrientation(*m.get<OrientationData>()); },
+    };
+
+    dispatch[msg.payload.index()](*this, msg);
+}
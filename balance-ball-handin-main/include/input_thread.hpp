@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "button.hpp"
+
+// ---------------------------
+// InputThread
+// ---------------------------
+// A single thread for all buttons. run() sleeps in epoll_wait until a
+// button's fd is readable or a debounce window ends, so an edge is read as
+// soon as the driver reports it and no thread wakes up while nothing
+// happens. Buttons whose device goes away (EOF, e.g. a closed pipe) are
+// dropped from the set.
+class InputThread
+{
+    int epfd = -1;
+    int wakeFd = -1; // eventfd, stop() makes epoll_wait return
+    std::atomic<bool> isActive{true};
+    std::vector<std::unique_ptr<Button>> buttons;
+
+public:
+    InputThread();
+    ~InputThread();
+
+    InputThread(const InputThread&) = delete;
+    InputThread& operator=(const InputThread&) = delete;
+
+    // Call before run(). Takes the button if it can be watched; otherwise
+    // returns false and leaves it with the caller, e.g. to read it with
+    // Button::readLoop() on a thread of its own.
+    bool add(std::unique_ptr<Button> &button);
+
+    void run();
+    void stop();
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include "iconsumer.hpp"
+#include "message.hpp"
+
+// ---------------------------
+// Journal file format
+// ---------------------------
+// JournalHeader followed by entries, each starting with a type byte:
+//   Topic:   type, id (u16), name length (u8), name
+//   Message: type, topic id (u16), timestamp ns (i64), Payload (raw bytes)
+// The file is preallocated and zero filled, so a type of End (0) marks the
+// end of the journal even if the recorder never got to close it. Payloads
+// are stored as-is, so record and replay must use the same build.
+static_assert(std::is_trivially_copyable_v<Payload>, "Payload is written to the journal as-is");
+
+enum class JournalEntry : uint8_t {
+    End = 0,
+    Topic = 1,
+    Message = 2
+};
+
+struct JournalHeader {
+    static constexpr uint32_t magicValue = 0x314a4242; // "BBJ1"
+    uint32_t magic;
+    uint32_t payloadSize; // sizeof(Payload) of the recording build
+};
+
+// ---------------------------
+// JournalWriter
+// ---------------------------
+// Appends every message it receives to a memory-mapped file. Subscribe it
+// to "#" to record everything that is published. Threads reserve space with
+// a single atomic add and copy the entry into the mapping, no syscalls.
+class JournalWriter : public IConsumer
+{
+    int fd = -1;
+    uint8_t *base = nullptr;
+    std::size_t capacity = 0;
+    std::atomic<std::size_t> used{0};
+    std::atomic<uint64_t> recorded{0};
+    std::atomic<uint64_t> dropped{0};
+
+    std::mutex topicMtx; // only taken the first time a topic is seen
+    std::array<std::atomic<bool>, 65536> namedTopics{};
+
+    uint8_t *reserve(std::size_t size);
+    void writeTopic(TopicId topic);
+
+public:
+    // capacity is the maximum journal size in bytes
+    explicit JournalWriter(const std::string &path, std::size_t capacity = 64 * 1024 * 1024);
+    ~JournalWriter();
+
+    bool isOpen() const { return base != nullptr; }
+    void onMessage(const Message &msg) override;
+
+    uint64_t recordedMessages() const { return recorded.load(); }
+    uint64_t droppedMessages() const { return dropped.load(); } // journal full
+};
+
+// ---------------------------
+// JournalReplayer
+// ---------------------------
+// Publishes a journal back through the Broker. Topics are registered by
+// name, so ids don't need to match the recording process.
+class JournalReplayer
+{
+    int fd = -1;
+    const uint8_t *base = nullptr;
+    std::size_t size = 0;
+
+public:
+    explicit JournalReplayer(const std::string &path);
+    ~JournalReplayer();
+
+    bool isOpen() const { return base != nullptr; }
+
+    // speed 1.0 keeps the original timing, 2.0 plays twice as fast and
+    // 0 publishes as fast as possible. Returns the number of messages.
+    uint64_t replay(double speed = 1.0);
+};
@@ -10,7 +10,7 @@ class Led : public IConsumer
 public:
     explicit Led(std::string path_name);
     ~Led();
-    void onMessage(const Message &msg) override;
+    void onBoundary(const BoundaryData &data) override;
     void on();
     void off();
 };
@@ -2,55 +2,65 @@
 #include <iostream>
 #include <memory>
 #include <string>
-#include <bits/stdc++.h>
-
-// // ---------------------------
-// // Message Data Base
-// // ---------------------------
-// struct MessageData {
-//     virtual ~MessageData() = default;
-// };
-
-// // ---------------------------
-// // Derived Message Data Types
-// // ---------------------------
-// struct AccelerometerData : public MessageData {
-//     int x, y, z;
-// };
-
-// struct ButtonData : public MessageData {
-//     int gpio, state;
-// };
+#include <cstdint>
+#include <chrono>
+#include <variant>
+
+// Index of a topic in the topic registry (see topics.hpp)
+using TopicId = uint16_t;
 
 // ---------------------------
-// Message
+// Message Data Types
 // ---------------------------
-struct Message {
-    std::string topic;
-    std::string data;
-    
-    Message(std::string topic, std::string data) : topic(std::move(topic)), data(std::move(data)) {}
+struct AccelerometerData {
+    double x, y, z;
+};
 
-    static std::string encodeAccelerometerData(const double &x, const double &y, const double &z) {
-        return std::to_string(x) + "," + std::to_string(y) + "," + std::to_string(z);
-    }
+struct ButtonData {
+    int gpio, value;
+};
 
-    static void decodeAccelerometerData(std::string data, double *x, double *y, double *z) {
-        std::stringstream ss(data);
-        char comma;
+struct BoundaryData {
+    int value; // 1 = ball outside the screen
+};
 
-        ss >> *x >> comma >> *y >> comma >> *z;
-    }
+struct OrientationData {
+    float roll, pitch; // radians, 0 = board level
+};
 
-    static std::string encodeButtonData(const int &gpio, const int &value) {
-        return std::to_string(gpio) + "," + std::to_string(value);
-    }
+// Payload of a message, std::monostate means "no data"
+using Payload = std::variant<std::monostate, AccelerometerData, ButtonData, BoundaryData, OrientationData>;
+
+// ---------------------------
+// Message
+// ---------------------------
+struct Message {
+    TopicId topic;
+    Payload payload;
+    std::chrono::steady_clock::time_point timestamp; // when the message was created
 
-    static void decodeButtonData(std::string data, int *gpio, int *value) {
-        std::stringstream ss(data);
-        char comma;
+    Message(TopicId topic, Payload payload)
+        : topic(topic), payload(payload), timestamp(std::chrono::steady_clock::now()) {}
 
-        ss >> *gpio >> comma >> *value;
-    }
+    // Typed access, nullptr if the payload holds another type
+    template <typename T>
+    const T *get() const { return std::get_if<T>(&payload); }
 
+    // Comma separated rendering of the payload, for debugging/logging only
+    std::string toString() const {
+        struct Render {
+            std::string operator()(std::monostate) const { return ""; }
+            std::string operator()(const AccelerometerData &d) const {
+                return std::to_string(d.x) + "," + std::to_string(d.y) + "," + std::to_string(d.z);
+            }
+            std::string operator()(const ButtonData &d) const {
+                return std::to_string(d.gpio) + "," + std::to_string(d.value);
+            }
+            std::string operator()(const BoundaryData &d) const { return std::to_string(d.value); }
+            std::string operator()(const OrientationData &d) const {
+                return std::to_string(d.roll) + "," + std::to_string(d.pitch);
+            }
+        };
+        return std::visit(Render{}, payload);
+    }
 };
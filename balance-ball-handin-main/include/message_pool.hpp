@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "message.hpp"
+
+// ---------------------------
+// Pool handles
+// ---------------------------
+// Returns a pooled Message to the MessagePool instead of deleting it
+struct MessageDeleter {
+    void operator()(Message *msg) const;
+};
+
+// Unique owner of a pooled message, what publishers create and hand over
+using MessagePtr = std::unique_ptr<Message, MessageDeleter>;
+
+// Shared, reference counted handle used when several mailboxes hold the
+// same message. The count lives in the pool slot, so copying never allocates.
+class MessageRef {
+    const Message *msg = nullptr;
+
+public:
+    MessageRef() = default;
+    explicit MessageRef(MessagePtr ptr) : msg(ptr.release()) {}
+
+    // Hand the reference over as a raw pointer (e.g. to store it in an
+    // atomic) and take it back again; the count is left untouched.
+    const Message *release() { const Message *m = msg; msg = nullptr; return m; }
+    static MessageRef adopt(const Message *m) { MessageRef ref; ref.msg = m; return ref; }
+
+    MessageRef(const MessageRef &other);
+    MessageRef(MessageRef &&other) noexcept : msg(other.msg) { other.msg = nullptr; }
+    MessageRef &operator=(MessageRef other) noexcept { std::swap(msg, other.msg); return *this; }
+    ~MessageRef() { reset(); }
+
+    void reset();
+    const Message &operator*() const { return *msg; }
+    const Message *operator->() const { return msg; }
+    explicit operator bool() const { return msg != nullptr; }
+};
+
+struct PoolStats {
+    std::size_t capacity = 0;      // messages preallocated in slabs
+    std::size_t inUse = 0;         // messages currently handed out
+    std::size_t highWaterMark = 0; // largest inUse seen so far
+    std::size_t slabs = 0;
+};
+
+// ---------------------------
+// MessagePool (Thread-Safe Singleton)
+// ---------------------------
+// Messages are carved out of preallocated slabs. Each thread keeps a small
+// cache of free slots and only takes the pool mutex to refill or flush it
+// in batches, so steady-state publish/deliver does no malloc/free.
+class MessagePool {
+public:
+    struct Slot {
+        alignas(Message) unsigned char storage[sizeof(Message)];
+        std::atomic<uint32_t> refs;
+        Slot *next;
+    };
+
+    static constexpr std::size_t slabSize = 256;
+    static constexpr std::size_t cacheBatch = 32;
+
+private:
+    std::mutex mtx;
+    Slot *freeList = nullptr; // guarded by mtx
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    std::atomic<std::size_t> inUse{0};
+    std::atomic<std::size_t> highWaterMark{0};
+
+    MessagePool() = default;
+    void addSlab();
+
+public:
+    MessagePool(const MessagePool&) = delete;
+    MessagePool& operator=(const MessagePool&) = delete;
+
+    // Never destroyed: detached delivery threads and the Broker singleton
+    // may still release messages while static objects are torn down.
+    static MessagePool& getInstance() {
+        static MessagePool *instance = new MessagePool();
+        return *instance;
+    }
+
+    // Preallocate slabs until at least `messages` slots exist
+    void reserve(std::size_t messages);
+
+    MessagePtr make(TopicId topic, const Payload &payload);
+    void retain(const Message *msg);
+    void release(const Message *msg);
+
+    // Used by the per-thread caches
+    std::size_t take(Slot **out, std::size_t n);
+    void give(Slot *head, Slot *tail);
+
+    PoolStats stats();
+};
+
+// Shorthand for MessagePool::getInstance().make(...)
+inline MessagePtr makeMessage(TopicId topic, const Payload &payload) {
+    return MessagePool::getInstance().make(topic, payload);
+}
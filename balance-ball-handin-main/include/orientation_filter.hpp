@@ -0,0 +1,35 @@
+#pragma once
+#include "message.hpp"
+
+// ---------------------------
+// ComplementaryFilter
+// ---------------------------
+// Roll and pitch from gyro and accelerometer samples taken at a fixed rate.
+// Integrating the gyro is smooth and responds at once but drifts, the angle
+// of the gravity vector doesn't drift but picks up every bump. The filter
+// follows the gyro and is pulled towards the accelerometer with time
+// constant tau, less so while the measured acceleration is far from 1 g
+// (the board is being shaken, not tilted).
+// update() does not allocate or lock; use one filter per sensor thread.
+class ComplementaryFilter {
+public:
+    explicit ComplementaryFilter(float sampleRateHz = 400, float tau = 0.5f);
+
+    void setSampleRate(float hz);
+    void reset() { initialized = false; }
+
+    // accel in g, gyro in degrees/s, both in sensor axes
+    OrientationData update(const float accel[3], const float gyro[3]);
+    OrientationData current() const { return {roll, pitch}; }
+
+    // Tilt from the accelerometer alone, what the filter corrects towards
+    static OrientationData fromGravity(const float accel[3]);
+
+private:
+    float tau;
+    float dt = 0;
+    float gain = 0; // share of the accelerometer angle per sample
+    float roll = 0;
+    float pitch = 0;
+    bool initialized = false;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <thread>
+#include "display.hpp"
+#include "game_state.hpp"
+#include "triple_buffer.hpp"
+
+struct RendererStats {
+    uint64_t submitted = 0; // frames handed to submit()
+    uint64_t rendered = 0;  // frames drawn and sent
+    uint64_t skipped = 0;   // frames replaced by a newer one before drawing
+
+    void print(std::ostream &out) const;
+};
+
+// ---------------------------
+// Renderer
+// ---------------------------
+// Owns the thread that draws. Game logic hands over frames with submit(),
+// which only copies into a TripleBuffer and wakes the thread, so the
+// physics and delivery threads never wait for the display bus. The thread
+// draws the newest frame, at most maxFps times per second, with the ball
+// interpolated for the time it draws; frames that arrive in between
+// replace each other.
+class Renderer
+{
+public:
+    explicit Renderer(Display &display, int maxFps = 30);
+    ~Renderer();
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    // Callers must not run submit() concurrently (GameControl holds its state lock)
+    void submit(const GameFrame &frame);
+
+    void setMaxFps(int maxFps);
+    RendererStats stats() const;
+
+private:
+    Display &display;
+    TripleBuffer<GameFrame> frames;
+    std::atomic<uint32_t> sequence{0}; // bumped per submit, the thread waits on it
+    std::atomic<int64_t> periodNs;
+    std::atomic<bool> isActive{true};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> rendered{0};
+    std::thread thread;
+
+    void renderThread();
+};
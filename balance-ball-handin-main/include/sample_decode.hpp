@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------
+// Raw sample decoding
+// ---------------------------
+// BMI160 data registers and headerless FIFO frames hold little-endian int16
+// x, y, z triples, one per enabled sensor (gyro first, then accelerometer).
+// decodeFrames converts a batch of such frames into physical units, one
+// structure of arrays per sensor, so the filter and the publishers read
+// plain float arrays. Uses NEON on ARM and SSE2 on x86-64, decodeFramesScalar
+// elsewhere and as the reference.
+
+// One sensor's samples, each pointer has room for the number of frames
+struct Vec3Array {
+    float *x;
+    float *y;
+    float *z;
+};
+
+// `sensors` (1 or 2) triples per frame, triple s is multiplied by scales[s]
+// and written to out[s]. src holds frames * sensors * 6 bytes.
+void decodeFrames(const uint8_t *src, std::size_t frames, int sensors, const float *scales, const Vec3Array *out);
+void decodeFramesScalar(const uint8_t *src, std::size_t frames, int sensors, const float *scales,
+                        const Vec3Array *out);
+
+// "neon", "sse2" or "scalar", the kernel decodeFrames uses
+const char *decodeKernelName();
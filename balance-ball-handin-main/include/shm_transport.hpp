@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "iconsumer.hpp"
+#include "message.hpp"
+#include "topic_trie.hpp"
+
+// ---------------------------
+// Shared memory layout
+// ---------------------------
+// One writer (the game process) appends records to a ring in a POSIX shared
+// memory segment. Each reader process keeps its own cursor, so readers never
+// write to the segment and can't slow down or block the writer. A record's
+// seq works as a seqlock: odd while it is written, 2 * (n + 1) once record
+// number n is complete. A reader that falls a full ring behind skips ahead.
+// Every run of the writer creates a new segment and sets magic last; it
+// clears magic when it exits, or when the next run finds the segment of a
+// crashed one, so that readers let go and attach to the new segment.
+static_assert(std::is_trivially_copyable_v<Payload>, "Payload is copied into shared memory as-is");
+
+struct alignas(64) ShmRecord {
+    std::atomic<uint64_t> seq;
+    TopicId topic;
+    int64_t timestampNs; // steady_clock (CLOCK_MONOTONIC), comparable across processes
+    Payload payload;
+};
+
+struct alignas(64) ShmHeader { // keeps the records that follow it aligned
+    static constexpr uint32_t magicValue = 0x42424d51; // "BBMQ"
+    static constexpr uint32_t maxTopics = 256;
+    static constexpr uint32_t maxNameLength = 64;
+
+    std::atomic<uint32_t> magic;
+    uint32_t capacity;                // records in the ring
+    std::atomic<uint64_t> head;       // number of records written so far
+    std::atomic<uint32_t> topicCount; // names valid in topicNames
+    char topicNames[maxTopics][maxNameLength];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory atomics must be lock-free");
+
+// ---------------------------
+// ShmPublisher
+// ---------------------------
+// Subscribe it to the topics to export, e.g. subscribe("#", shmPublisher,
+// options). onMessage() is the ring's only writer and is not thread-safe:
+// subscribe with DeliveryMode::Async, so that a single delivery thread
+// calls it whatever thread publishes. Each message is copied into a record.
+class ShmPublisher : public IConsumer
+{
+    int fd = -1;
+    std::string name;
+    ShmHeader *header = nullptr;
+    ShmRecord *records = nullptr;
+    std::size_t mappedSize = 0;
+    std::vector<bool> namedTopics;
+
+public:
+    // name is the shm_open name, e.g. "/balance_ball"
+    explicit ShmPublisher(std::string name, uint32_t capacity = 4096);
+    ~ShmPublisher();
+
+    bool isOpen() const { return header != nullptr; }
+    void onMessage(const Message &msg) override;
+};
+
+// ---------------------------
+// ShmSubscriber
+// ---------------------------
+// Used in the reading process. pump() copies new records straight out of
+// the mapping and republishes them into this process' Broker, so ordinary
+// IConsumers (e.g. Logger) subscribe to them as usual. When the writer
+// exits or restarts, pump() attaches to its next segment and reads that
+// from the first record.
+class ShmSubscriber
+{
+    std::string name;
+    int fd = -1;
+    ShmHeader *header = nullptr;
+    ShmRecord *records = nullptr;
+    std::size_t mappedSize = 0;
+    uint64_t cursor = 0;
+    uint64_t lost = 0;
+
+    TopicTrie<bool> patterns;
+    std::vector<TopicId> localIds; // remote topic id -> id in this process, resolved lazily
+    std::vector<int8_t> wanted;    // remote topic id -> -1 unknown, 0 no, 1 yes
+
+    bool attach(bool quiet);
+    void detach();
+    void restart();
+    bool resolve(TopicId remote);
+
+public:
+    explicit ShmSubscriber(const std::string &name);
+    ~ShmSubscriber();
+
+    // False while no writer is running
+    bool isOpen() const { return header != nullptr; }
+
+    // Only records whose topic matches one of the patterns are republished
+    void subscribe(std::string_view pattern);
+
+    // Republishes all new records, returns how many were delivered
+    std::size_t pump();
+
+    // Records overwritten before this reader got to them
+    uint64_t lostRecords() const { return lost; }
+};
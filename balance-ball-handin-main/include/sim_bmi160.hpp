@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SPIdriver.hpp"
+#include "event_source.hpp"
+
+// Physical state of the simulated sensor at one instant
+struct Motion {
+    double accel[3] = {0, 0, 1}; // g
+    double gyro[3] = {0, 0, 0};  // degrees/s
+};
+
+// Bus cost model. A transaction takes
+//   perTransaction + segments * perSegment + bytes * 8 / clockHz
+// and submit() busy-waits that long, so the caller sees realistic timing.
+struct BusTiming {
+    uint32_t clockHz = 1000000;                       // 0: infinitely fast
+    std::chrono::nanoseconds perTransaction{20000};   // ioctl + driver
+    std::chrono::nanoseconds perSegment{2000};        // chip select gap
+};
+
+struct SimBusStats {
+    uint64_t transactions = 0;
+    uint64_t segments = 0;
+    uint64_t bytes = 0;
+    uint64_t busyNs = 0;          // modelled bus time
+    uint64_t samplesGenerated = 0;
+    uint64_t fifoOverflows = 0;   // frames lost because the FIFO was full
+};
+
+// ---------------------------
+// SimBMI160
+// ---------------------------
+// A BMI160 behind the SPIDriver interface: register map, power modes, data
+// ready status bits, the headerless FIFO (gyro and/or accel frames) with
+// watermark, and INT1 as a ManualEvent. Samples are produced at the
+// configured output data rate from a motion script, on a clock that may
+// run faster than real time (timeScale) to stress the pipeline.
+// Header mode FIFO, magnetometer and the motion-detection engines are not
+// modelled.
+class SimBMI160 : public SPIDriver {
+public:
+    using MotionScript = std::function<Motion(double seconds)>;
+
+    static constexpr uint8_t chipId = 0xD1;
+
+    explicit SimBMI160(BusTiming timing = {}, double timeScale = 1.0);
+    ~SimBMI160() override;
+
+    bool isOpen() const override { return true; }
+    int8_t submit(SPITransaction &t) override;
+
+    // Defaults to holding the board level and still
+    void setMotion(MotionScript script);
+    // Plays back "t,ax,ay,az[,gx,gy,gz]" lines (seconds, g, degrees/s),
+    // holding each row until the next one; returns false if unreadable
+    bool replay(const std::string &csvPath, bool loop = true);
+    void setNoise(double accelG, double gyroDps) {
+        std::lock_guard<std::mutex> lock(mtx);
+        accelNoise = accelG;
+        gyroNoise = gyroDps;
+    }
+
+    // INT1 as an event source for Accelerometer::setEventSource(). Starts a
+    // thread that produces samples on time so edges fire without bus traffic.
+    std::unique_ptr<EventSource> interrupt();
+
+    SimBusStats stats();
+
+private:
+    BusTiming timing;
+    double timeScale;
+    std::chrono::steady_clock::time_point epoch;
+
+    std::mutex mtx; // registers, FIFO, script; taken by submit() and the ticker
+    std::array<uint8_t, 128> regs{};
+    std::array<uint8_t, 1024> fifo{};
+    std::size_t fifoHead = 0; // oldest byte
+    std::size_t fifoFill = 0;
+    bool accelOn = false;
+    bool gyroOn = false;
+    bool int1Level = false;  // INT1 line state, a rising edge fires the event
+    bool freshSample = false; // data ready pulses once per sample
+    double nextSample = 0;   // simulated time of the next output period
+    MotionScript script;
+    double accelNoise = 0;
+    double gyroNoise = 0;
+    std::mt19937 rng{160};
+    std::vector<std::array<double, 7>> recording; // replay rows
+    SimBusStats counters;
+
+    std::unique_ptr<ManualEvent> int1;
+    std::atomic<bool> ticking{false};
+    std::thread ticker;
+
+    double now() const; // simulated seconds since construction
+    double odrHz() const;
+    void advance();     // produce the samples due by now()
+    void sample(double t);
+    void pushFifo(const uint8_t *frame, std::size_t n);
+    void updateInterrupt();
+    uint8_t readByte(uint8_t reg);
+    void writeByte(uint8_t reg, uint8_t value);
+    void command(uint8_t cmd);
+    void reset();
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include "I2Cdriver.hpp"
+#include "sprite.hpp"
+
+// I2C bus cost model. A transfer (one ioctl or write) takes
+//   perTransfer + bits / clockHz
+// with 9 bits per byte (8 data, 1 ACK) and per message an address byte
+// plus start and stop. submit() busy-waits that long.
+struct I2CTiming {
+    uint32_t clockHz = 400000;                    // 0: infinitely fast
+    std::chrono::nanoseconds perTransfer{50000};  // syscall + driver
+
+    static I2CTiming instant() { return {0, std::chrono::nanoseconds(0)}; }
+};
+
+// ---------------------------
+// SimSSD1306
+// ---------------------------
+// A 128x32 SSD1306 behind the I2CDriver interface, for running Display
+// without a Pi. It decodes the control bytes, the commands and their
+// arguments, and writes data into the display RAM through the horizontal,
+// vertical or page addressing mode and the column/page windows. Pages 0-3
+// of the RAM are the framebuffer, what the panel shows. Each batch
+// (submit) counts as one frame; frames can be dumped as PBM images or
+// logged as hashes to compare runs. Scrolling, inversion, remapping and
+// contrast are accepted but not modelled. Writes to other addresses are
+// not acknowledged.
+class SimSSD1306 : public I2CDriver {
+public:
+    explicit SimSSD1306(I2CTiming timing = {}, uint8_t address = 0x3C);
+    ~SimSSD1306() override;
+
+    bool isOpen() const override { return true; }
+
+    std::array<uint8_t, OLED_BUFFER_SIZE> framebuffer();
+    uint64_t frames();
+    bool displayOn();
+
+    // Writes every frame to <dir>/frame_NNNNNN.pbm, an empty dir stops it
+    void dumpFrames(const std::string &dir);
+    // Appends "<frame> <hash>" per frame to path, false if it can't be opened
+    bool logHashes(const std::string &path);
+
+    // Lit pixels are black in the image
+    static bool writePbm(const std::string &path, const uint8_t *frame);
+    // FNV-1a 64 of a page buffer
+    static uint64_t hash(const uint8_t *frame);
+
+protected:
+    int8_t submit(I2CTransaction &t) override;
+    int8_t transmit(uint8_t address, const uint8_t *buf, uint16_t length) override;
+    int8_t receive(uint8_t address, uint8_t *buf, uint16_t length) override;
+
+private:
+    I2CTiming timing;
+    uint8_t address;
+
+    std::mutex mtx; // RAM, registers and outputs
+    uint8_t ram[8][OLED_WIDTH] = {};
+    uint8_t mode = 2; // addressing mode, page addressing after reset
+    int columnStart = 0, columnEnd = OLED_WIDTH - 1;
+    int pageStart = 0, pageEnd = 7;
+    int column = 0, page = 0;
+    bool on = false;
+    uint8_t cmd[7];   // command being received, with its arguments
+    int cmdLength = 0;
+    uint64_t frameCount = 0;
+    std::string frameDir;
+    FILE *hashLog = nullptr;
+
+    void message(const uint8_t *data, uint16_t length);
+    void commandByte(uint8_t byte);
+    void execute();
+    void dataByte(uint8_t byte);
+    void endFrame();
+    void wait(std::chrono::steady_clock::time_point start, uint64_t bits, int transfers);
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include "bitmaps.hpp"
+
+#define OLED_WIDTH  128
+#define OLED_HEIGHT 32
+#define OLED_PAGES  (OLED_HEIGHT / 8)
+#define OLED_BUFFER_SIZE (OLED_WIDTH * OLED_PAGES)
+
+// ---------------------------
+// Page buffer drawing
+// ---------------------------
+// The SSD1306 page buffer holds one byte per column and page, bit 0 is the
+// top row of the page. An 8 pixel high sprite at row y covers page y / 8
+// shifted down by y % 8 and, unless that is 0, the page below. Pre-shifting
+// the sprite for all 8 offsets turns drawing it into one OR (or AND-NOT, to
+// erase it) per column and page, without touching single pixels.
+
+// An 8x8 sprite as page columns: for shift s, top[s] goes into the sprite's
+// first page and bottom[s] into the next one
+struct ShiftedSprite {
+    uint8_t top[8][8];
+    uint8_t bottom[8][8];
+};
+
+// Pre-shifts a row-major bitmap (one byte per row, most significant bit left)
+constexpr ShiftedSprite preShift(const uint8_t (&rows)[8])
+{
+    ShiftedSprite sprite{};
+    for (int c = 0; c < 8; ++c) {
+        unsigned column = 0;
+        for (int r = 0; r < 8; ++r)
+            column |= ((rows[r] >> (7 - c)) & 1u) << r;
+        for (int shift = 0; shift < 8; ++shift) {
+            sprite.top[shift][c] = uint8_t(column << shift);
+            sprite.bottom[shift][c] = uint8_t(column >> (8 - shift));
+        }
+    }
+    return sprite;
+}
+
+inline constexpr ShiftedSprite ballSprite = preShift(ballBitmap);
+
+// Sets (blitSprite) or clears (eraseSprite) the sprite's pixels with (x, y)
+// its top left corner in the OLED_BUFFER_SIZE page buffer `frame`, clipped
+// to the screen
+void blitSprite(uint8_t *frame, int x, int y, const ShiftedSprite &sprite);
+void eraseSprite(uint8_t *frame, int x, int y, const ShiftedSprite &sprite);
+
+// Columns of a character in the 5x7 font, bit 0 on top; characters outside
+// the font come out blank
+const uint8_t *glyph5x7(char c);
+
+// ---------------------------
+// ScoreText
+// ---------------------------
+// "Score <n>" in the first page, as the OLED library prints it at (0, 0)
+// with text size 1: 6 columns per character, 5 of glyph and one blank.
+// The columns are rendered again only when the score changes; drawing
+// copies them into the frame.
+class ScoreText
+{
+public:
+    // Overwrites the text's columns of page 0, including what a longer
+    // text drawn before left there
+    void draw(uint8_t *frame, int score);
+
+    uint64_t renders() const { return renderCount; }
+
+private:
+    uint8_t columns[OLED_WIDTH] = {0};
+    int span = 0; // columns draw() writes
+    int cachedScore = 0;
+    bool valid = false;
+    uint64_t renderCount = 0;
+
+    void render(int score);
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// ---------------------------
+// TopicTrie
+// ---------------------------
+// Subscription patterns split on '/' and stored level by level. A level may
+// be '+' (exactly one level) or, as the last level, '#' (zero or more
+// levels), e.g. "sensor/#" matches "sensor/accl/0" and "sensor".
+// Nodes live in a flat vector so the trie is cheap to copy (read-copy-update).
+template <typename T>
+class TopicTrie {
+    struct Node {
+        std::vector<std::pair<std::string, uint32_t>> children; // level -> node index
+        std::vector<T> values;
+    };
+
+    std::vector<Node> nodes{Node{}};
+
+    // Calls fn(level) for every '/'-separated level of a topic name
+    template <typename Fn>
+    static void forEachLevel(std::string_view name, Fn fn) {
+        std::size_t start = 0;
+        for (;;) {
+            std::size_t end = name.find('/', start);
+            fn(name.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+            if (end == std::string_view::npos)
+                return;
+            start = end + 1;
+        }
+    }
+
+    static std::vector<std::string_view> split(std::string_view name) {
+        std::vector<std::string_view> levels;
+        forEachLevel(name, [&](std::string_view level) { levels.push_back(level); });
+        return levels;
+    }
+
+    int child(uint32_t node, std::string_view level) const {
+        for (auto& [key, index] : nodes[node].children)
+            if (key == level)
+                return index;
+        return -1;
+    }
+
+    void collect(uint32_t node, const std::vector<std::string_view>& levels, std::size_t depth,
+                 std::vector<T>& out) const {
+        // '#' also matches the parent level itself
+        int hash = child(node, "#");
+        if (hash >= 0)
+            out.insert(out.end(), nodes[hash].values.begin(), nodes[hash].values.end());
+
+        if (depth == levels.size()) {
+            out.insert(out.end(), nodes[node].values.begin(), nodes[node].values.end());
+            return;
+        }
+
+        int exact = child(node, levels[depth]);
+        if (exact >= 0)
+            collect(exact, levels, depth + 1, out);
+
+        int plus = child(node, "+");
+        if (plus >= 0)
+            collect(plus, levels, depth + 1, out);
+    }
+
+public:
+    // Wildcards are whole levels and '#' must be the last level
+    static bool valid(std::string_view pattern) {
+        if (pattern.empty())
+            return false;
+        bool ok = true;
+        bool sawHash = false;
+        forEachLevel(pattern, [&](std::string_view level) {
+            if (sawHash)
+                ok = false;
+            if (level == "#")
+                sawHash = true;
+            else if (level.find_first_of("+#") != std::string_view::npos && level != "+")
+                ok = false;
+        });
+        return ok;
+    }
+
+    // Concrete topic names may not contain wildcards
+    static bool concrete(std::string_view name) {
+        return valid(name) && name.find_first_of("+#") == std::string_view::npos;
+    }
+
+    void insert(std::string_view pattern, T value) {
+        uint32_t node = 0;
+        forEachLevel(pattern, [&](std::string_view level) {
+            int next = child(node, level);
+            if (next < 0) {
+                next = static_cast<int>(nodes.size());
+                nodes[node].children.emplace_back(std::string(level), next);
+                nodes.emplace_back();
+            }
+            node = next;
+        });
+        nodes[node].values.push_back(std::move(value));
+    }
+
+    // Removes the values of `pattern` for which pred(value) is true
+    template <typename Pred>
+    void remove(std::string_view pattern, Pred pred) {
+        int node = 0;
+        forEachLevel(pattern, [&](std::string_view level) {
+            if (node >= 0)
+                node = child(node, level);
+        });
+        if (node >= 0)
+            std::erase_if(nodes[node].values, pred);
+    }
+
+    // Removes matching values from every node
+    template <typename Pred>
+    void removeAll(Pred pred) {
+        for (auto& node : nodes)
+            std::erase_if(node.values, pred);
+    }
+
+    // Appends all values whose pattern matches the concrete topic `name`
+    void match(std::string_view name, std::vector<T>& out) const {
+        collect(0, split(name), 0, out);
+    }
+
+    // Visits every stored value
+    template <typename Fn>
+    void forEachValue(Fn fn) const {
+        for (auto& node : nodes)
+            for (auto& value : node.values)
+                fn(value);
+    }
+
+    // Visits the values stored under exactly `pattern`
+    template <typename Fn>
+    void forEach(std::string_view pattern, Fn fn) const {
+        int node = 0;
+        forEachLevel(pattern, [&](std::string_view level) {
+            if (node >= 0)
+                node = child(node, level);
+        });
+        if (node >= 0)
+            for (auto& value : nodes[node].values)
+                fn(value);
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include "message.hpp"
+
+// Delivery lane of a topic. High priority messages are delivered to async
+// consumers ahead of any queued normal priority messages.
+enum class Priority : uint8_t {
+    Normal,
+    High
+};
+
+// ---------------------------
+// Topic
+// ---------------------------
+// A topic binds an id to its payload type, so publish/subscribe are checked
+// by the compiler and the Broker can index a flat array by id. Names are
+// hierarchical ("sensor/accl/0"); subscriptions may use '+' and '#'.
+template <typename Payload>
+struct Topic {
+    using payload_type = Payload;
+    TopicId id;
+    std::string_view name;
+};
+
+// ---------------------------
+// Topic registry
+// ---------------------------
+// Built-in topics have fixed ids. More topics (other buttons, sensors) can
+// be added at runtime with Broker::registerTopic, they get ids from count.
+namespace topics {
+
+inline constexpr Topic<AccelerometerData> accl{0, "sensor/accl/0"};
+inline constexpr Topic<ButtonData> btn{1, "input/btn/27"};
+inline constexpr Topic<BoundaryData> boundary{2, "game/boundary"};
+inline constexpr Topic<OrientationData> orientation{3, "sensor/orientation/0"};
+
+inline constexpr std::size_t count = 4;
+
+// Names and priorities of the built-in topics indexed by id
+inline constexpr std::array<std::string_view, count> names = {accl.name, btn.name, boundary.name, orientation.name};
+inline constexpr std::array<Priority, count> priorities = {Priority::Normal, Priority::High, Priority::High,
+                                                           Priority::Normal};
+
+static_assert(accl.id == 0 && btn.id == 1 && boundary.id == 2 && orientation.id == 3,
+              "Topic ids must match their index in names");
+
+} // namespace topics
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// ------------------------------
+// TripleBuffer (one writer, one reader, lock-free)
+// ------------------------------
+// The writer fills a back slot and swaps it with the middle one, the reader
+// swaps the middle slot with its front one when there is something new.
+// Neither side ever waits for the other: the writer can publish as often as
+// it likes (older values are overwritten) and the reader always gets the
+// newest complete value. Several writers need to serialize among themselves.
+template <typename T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t fresh = 4; // set in `middle` when the writer swapped it in
+
+    T slots[3]{};
+    std::atomic<uint8_t> middle{1};
+    uint8_t back = 0;  // writer's slot
+    uint8_t front = 2; // reader's slot
+
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    void write(const T& value) {
+        slots[back] = value;
+        back = middle.exchange(back | fresh, std::memory_order_acq_rel) & 3;
+    }
+
+    // Copies the newest value into `value`, false if nothing was written
+    // since the last read
+    bool read(T& value) {
+        if (!(middle.load(std::memory_order_relaxed) & fresh))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+        value = slots[front];
+        return true;
+    }
+};
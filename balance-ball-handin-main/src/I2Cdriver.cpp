@@ -1,36 +1,257 @@
 #include "I2Cdriver.hpp"
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <fcntl.h>
 #include <linux/i2c-dev.h>
+#include <linux/i2c.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
+#include <iomanip>
 #include <iostream>
+#include <utility>
 
-I2CDriver::I2CDriver() {
-  if (fd_ >= 0) {
-    perror("I2C bus already open");
+// I2CTransaction
+I2CTransaction::Message *I2CTransaction::add(uint8_t address, uint16_t length,
+                                             uint8_t *dst) {
+  if (!ok_ || !fits(length)) {
+    ok_ = false;
+    return nullptr;
   }
-  const char *i2c_device_file =
-      "/dev/i2c-1"; // *** IMPORTANT: CHANGE IF YOUR BUS IS DIFFERENT ***
-  fd_ = open(i2c_device_file, O_RDWR);
+  Message *m = &msg_[count_++];
+  m->offset = static_cast<uint16_t>(used_);
+  m->length = length;
+  m->address = address;
+  m->dst = dst;
+  used_ += length;
+  return m;
+}
+
+I2CTransaction &I2CTransaction::write(uint8_t address, const uint8_t *data,
+                                      uint16_t length) {
+  if (Message *m = add(address, length, nullptr))
+    memcpy(buf_ + m->offset, data, length);
+  return *this;
+}
+
+I2CTransaction &I2CTransaction::read(uint8_t address, uint8_t *dst,
+                                     uint16_t length) {
+  add(address, length, dst);
+  return *this;
+}
+
+// I2CDriver
+I2CDriver::I2CDriver(const char *i2c_device) {
+  fd_ = open(i2c_device, O_RDWR);
   if (fd_ < 0) {
     perror("Failed to open I2C device file");
   }
 }
 
 I2CDriver::~I2CDriver() {
-  close(fd_);
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stopping_ = true;
+  }
+  work_.notify_one();
+  if (flushThread_.joinable())
+    flushThread_.join();
+
+  if (fd_ >= 0)
+    close(fd_);
   fd_ = -1;
 }
 
 int8_t I2CDriver::write(uint8_t slaveAddress, const uint8_t *buf,
-                         uint16_t length) {
-  if (ioctl(fd_, I2C_SLAVE, slaveAddress) < 0) {
-    perror("Failed setting i2c slave");
-    return -1;
+                        uint16_t length) {
+  {
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    ++stats_.writes;
+  }
+
+  if (batching_) {
+    I2CTransaction &t = slots_[pending_];
+    if (!t.fits(length)) {
+      int8_t result = flush();
+      batching_ = true;
+      if (result != 0)
+        return result;
+    }
+    t.write(slaveAddress, buf, length);
+    if (!t.ok()) {
+      fprintf(stderr, "I2C write of %u bytes does not fit a batch\n", length);
+      t.clear();
+      return -2;
+    }
+    return 0;
+  }
+
+  waitIdle();
+  auto start = std::chrono::steady_clock::now();
+  int8_t result = transmit(slaveAddress, buf, length);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(statsMtx_);
+  ++stats_.messages;
+  stats_.bytes += length;
+  stats_.busNs += ns;
+  stats_.errors += result != 0;
+  return result;
+}
+
+int8_t I2CDriver::read(uint8_t slaveAddress, uint8_t *buf, uint16_t length) {
+  if (batching_) {
+    int8_t result = flush();
+    if (result != 0)
+      return result;
   }
 
+  waitIdle();
+  auto start = std::chrono::steady_clock::now();
+  int8_t result = receive(slaveAddress, buf, length);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(statsMtx_);
+  ++stats_.reads;
+  ++stats_.messages;
+  stats_.bytes += length;
+  stats_.busNs += ns;
+  stats_.errors += result != 0;
+  return result;
+}
+
+void I2CDriver::beginBatch() { batching_ = true; }
+
+int8_t I2CDriver::flush() {
+  batching_ = false;
+  waitIdle();
+  I2CTransaction &t = slots_[pending_];
+  int8_t result = send(t);
+  t.clear();
+  return result;
+}
+
+void I2CDriver::flushAsync(std::function<void(int8_t)> done) {
+  batching_ = false;
+  std::unique_lock<std::mutex> lock(mtx_);
+  idle_.wait(lock, [this]() { return !busy_; });
+
+  if (slots_[pending_].messages() == 0) {
+    lock.unlock();
+    if (done)
+      done(0);
+    return;
+  }
+
+  // The filled slot goes to the flush thread, the next batch fills the other
+  pending_ = 1 - pending_;
+  slots_[pending_].clear();
+  done_ = std::move(done);
+  busy_ = true;
+  if (!flushThread_.joinable())
+    flushThread_ = std::thread([this]() { flushLoop(); });
+  work_.notify_one();
+}
+
+void I2CDriver::waitIdle() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  idle_.wait(lock, [this]() { return !busy_; });
+}
+
+void I2CDriver::flushLoop() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (true) {
+    work_.wait(lock, [this]() { return busy_ || stopping_; });
+    if (!busy_)
+      return;
+
+    I2CTransaction &t = slots_[1 - pending_];
+    auto done = std::move(done_);
+    done_ = nullptr;
+    lock.unlock();
+
+    int8_t result = send(t);
+    t.clear();
+    if (done)
+      done(result);
+
+    lock.lock();
+    busy_ = false;
+    idle_.notify_all();
+  }
+}
+
+int8_t I2CDriver::send(I2CTransaction &t) {
+  if (t.messages() == 0 && t.ok())
+    return 0;
+
+  auto start = std::chrono::steady_clock::now();
+  int8_t result = submit(t);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(statsMtx_);
+  ++stats_.flushes;
+  stats_.messages += t.messages();
+  stats_.bytes += t.bytes();
+  stats_.busNs += ns;
+  stats_.errors += result != 0;
+  return result;
+}
+
+int8_t I2CDriver::submit(I2CTransaction &t) {
+  if (!t.ok_) {
+    fprintf(stderr, "I2C transaction too large\n");
+    return -2;
+  }
+
+  struct i2c_msg msgs[I2CTransaction::maxMessages];
+  for (size_t i = 0; i < t.count_; ++i) {
+    const I2CTransaction::Message &m = t.msg_[i];
+    msgs[i].addr = m.address;
+    msgs[i].flags = m.dst ? I2C_M_RD : 0;
+    msgs[i].len = m.length;
+    msgs[i].buf = t.buf_ + m.offset;
+  }
+  struct i2c_rdwr_ioctl_data data;
+  data.msgs = msgs;
+  data.nmsgs = static_cast<uint32_t>(t.count_);
+
+  countSyscalls(1);
+  if (ioctl(fd_, I2C_RDWR, &data) < 0) {
+    perror("Failed I2C_RDWR transfer");
+    return -2;
+  }
+
+  finish(t);
+  return 0;
+}
+
+void I2CDriver::finish(I2CTransaction &t) {
+  for (size_t i = 0; i < t.count_; ++i) {
+    const I2CTransaction::Message &m = t.msg_[i];
+    if (m.dst)
+      memcpy(m.dst, t.buf_ + m.offset, m.length);
+  }
+}
+
+int8_t I2CDriver::transmit(uint8_t address, const uint8_t *buf,
+                           uint16_t length) {
+  if (address != address_) {
+    countSyscalls(1, 1);
+    if (ioctl(fd_, I2C_SLAVE, address) < 0) {
+      perror("Failed setting i2c slave");
+      address_ = -1;
+      return -1;
+    }
+    address_ = address;
+  }
+
+  countSyscalls(1);
   if (::write(fd_, buf, length) != length) {
     perror("Failed writing i2c slave");
     return -2;
@@ -39,12 +260,18 @@ int8_t I2CDriver::write(uint8_t slaveAddress, const uint8_t *buf,
   return 0; // Success
 }
 
-int8_t I2CDriver::read(uint8_t slaveAddress, uint8_t *buf, uint16_t length) {
-  if (ioctl(fd_, I2C_SLAVE, slaveAddress) < 0) {
-    perror("Failed setting i2c slave");
-    return -1;
+int8_t I2CDriver::receive(uint8_t address, uint8_t *buf, uint16_t length) {
+  if (address != address_) {
+    countSyscalls(1, 1);
+    if (ioctl(fd_, I2C_SLAVE, address) < 0) {
+      perror("Failed setting i2c slave");
+      address_ = -1;
+      return -1;
+    }
+    address_ = address;
   }
 
+  countSyscalls(1);
   ssize_t bytesRead = ::read(fd_, buf, length);
   if (bytesRead != static_cast<ssize_t>(length)) {
     perror("Failed or incomplete read of i2c slave");
@@ -53,3 +280,27 @@ int8_t I2CDriver::read(uint8_t slaveAddress, uint8_t *buf, uint16_t length) {
 
   return 0; // Success
 }
+
+void I2CDriver::countSyscalls(uint64_t syscalls, uint64_t addressChanges) {
+  std::lock_guard<std::mutex> lock(statsMtx_);
+  stats_.syscalls += syscalls;
+  stats_.addressChanges += addressChanges;
+}
+
+I2CStats I2CDriver::stats() const {
+  std::lock_guard<std::mutex> lock(statsMtx_);
+  return stats_;
+}
+
+void I2CStats::print(std::ostream &out) const {
+  auto flags = out.flags();
+  auto precision = out.precision();
+  out << "[I2C] " << messages << " messages (" << writes << " writes, "
+      << reads << " reads), " << bytes << " bytes, " << syscalls
+      << " syscalls (" << addressChanges << " address changes), " << flushes
+      << " flushes, " << errors << " errors, bus " << std::fixed
+      << std::setprecision(1) << busNs / 1e6 << " ms, per flush "
+      << syscallsPerFlush() << " syscalls and " << busUsPerFlush() << " us\n";
+  out.flags(flags);
+  out.precision(precision);
+}
@@ -7,30 +7,87 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <chrono>
 #include <thread>
 #include <unistd.h>
-#include <vector>
+#include <utility>
+
+// SPITransaction
+SPITransaction::Segment *SPITransaction::add(uint16_t length, uint16_t skip,
+                                             uint8_t *dst) {
+  if (!ok_ || count_ == maxSegments || used_ + length > maxBytes) {
+    ok_ = false;
+    return nullptr;
+  }
+  Segment *s = &seg_[count_++];
+  s->offset = static_cast<uint16_t>(used_);
+  s->length = length;
+  s->skip = skip;
+  s->dst = dst;
+  used_ += length;
+  return s;
+}
+
+SPITransaction &SPITransaction::readReg(uint8_t reg, uint8_t *dst,
+                                        uint16_t length) {
+  if (Segment *s = add(length + 1, 1, dst)) {
+    memset(buf_ + s->offset, 0, s->length);
+    buf_[s->offset] = reg | 0x80;
+  }
+  return *this;
+}
+
+SPITransaction &SPITransaction::writeReg(uint8_t reg, const uint8_t *data,
+                                         uint16_t length) {
+  if (Segment *s = add(length + 1, 1, nullptr)) {
+    buf_[s->offset] = reg;
+    memcpy(buf_ + s->offset + 1, data, length);
+  }
+  return *this;
+}
+
+SPITransaction &SPITransaction::transfer(const uint8_t *tx, uint8_t *rx,
+                                         uint16_t length) {
+  if (Segment *s = add(length, 0, rx)) {
+    if (tx)
+      memcpy(buf_ + s->offset, tx, length);
+    else
+      memset(buf_ + s->offset, 0, length);
+  }
+  return *this;
+}
 
 // Your SPIDriver class implementation
 SPIDriver::SPIDriver(const char *spi_device) {
- 
-  /*
-   * TODO:
-   * Open spidev node
-   * Set SPI mode
-   * Set bits per word
-   * Set SPI speed
- */
-
+  fd_ = open(spi_device, O_RDWR);
+  if (fd_ < 0) {
+    perror("Failed to open SPI device");
+    return;
+  }
+  if (ioctl(fd_, SPI_IOC_WR_MODE, &mode_) < 0)
+    perror("Failed setting SPI mode");
+  if (ioctl(fd_, SPI_IOC_WR_BITS_PER_WORD, &bits_) < 0)
+    perror("Failed setting SPI bits per word");
+  if (ioctl(fd_, SPI_IOC_WR_MAX_SPEED_HZ, &speed_) < 0)
+    perror("Failed setting SPI speed");
 }
 
-SPIDriver::~SPIDriver() {
+SPIDriver::SPIDriver(SPIDriver &&other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), speed_(other.speed_),
+      mode_(other.mode_), bits_(other.bits_) {}
 
-  /*
-   * TODO:
-   * Close spidev node
-   */
+SPIDriver &SPIDriver::operator=(SPIDriver &&other) noexcept {
+  std::swap(fd_, other.fd_);
+  speed_ = other.speed_;
+  mode_ = other.mode_;
+  bits_ = other.bits_;
+  return *this;
+}
 
+SPIDriver::~SPIDriver() {
+  if (fd_ >= 0)
+    close(fd_);
+  fd_ = -1;
 }
 
 // This low-level transfer method is the correct way to perform a full-duplex
@@ -53,49 +110,63 @@ int8_t SPIDriver::transfer(const uint8_t *tx_buffer, uint8_t *rx_buffer,
   return 0;
 }
 
-int8_t SPIDriver::write(const uint8_t slaveAddress, const uint8_t *buf,
-                        const uint16_t length) {
+int8_t SPIDriver::submit(SPITransaction &t) {
+  if (!t.ok_) {
+    fprintf(stderr, "SPI transaction too large\n");
+    return 1;
+  }
+  if (t.count_ == 0)
+    return 0;
+
+  // Every segment is received in place over its own tx bytes
+  struct spi_ioc_transfer tr[SPITransaction::maxSegments];
+  memset(tr, 0, sizeof(tr[0]) * t.count_);
+  for (size_t i = 0; i < t.count_; ++i) {
+    uint8_t *p = t.buf_ + t.seg_[i].offset;
+    tr[i].tx_buf = reinterpret_cast<uint64_t>(p);
+    tr[i].rx_buf = reinterpret_cast<uint64_t>(p);
+    tr[i].len = t.seg_[i].length;
+    tr[i].speed_hz = speed_;
+    tr[i].bits_per_word = bits_;
+    tr[i].cs_change = i + 1 < t.count_; // release CS between segments
+  }
+
+  if (ioctl(fd_, SPI_IOC_MESSAGE(t.count_), tr) < 0) {
+    perror("SPI transfer failed");
+    return 1;
+  }
 
-  uint8_t reg_addr = slaveAddress;
-  std::vector<uint8_t> tx_buffer(length + 1);
-  std::vector<uint8_t> rx_buffer(length + 1);
+  finish(t);
+  return 0;
+}
 
-  /*
-   * TODO:
-   * Implement write
-   * - The register address is received via the 'slaveAddress' parameter
-   * - The total length of the SPI transaction is the data length + 1 byte for the address
-   * - For a write, we can use a dummy rx buffer to receive the data
-   */
+void SPIDriver::finish(SPITransaction &t) {
+  for (size_t i = 0; i < t.count_; ++i) {
+    const SPITransaction::Segment &s = t.seg_[i];
+    if (s.dst)
+      memcpy(s.dst, t.buf_ + s.offset + s.skip, s.length - s.skip);
+  }
+}
 
-  // Call transfer with tx/rx buffers and size
-  return transfer(tx_buffer.data(), rx_buffer.data(), tx_buffer.size());
+int8_t SPIDriver::write(const uint8_t slaveAddress, const uint8_t *buf,
+                        const uint16_t length) {
+  // The register address is sent as given, followed by the data
+  SPITransaction t;
+  t.writeReg(slaveAddress, buf, length);
+  return submit(t);
 }
 
 int8_t SPIDriver::read(const uint8_t slaveAddress, uint8_t *buf,
                        const uint16_t length) {
-  uint8_t reg_addr = slaveAddress;
-  std::vector<uint8_t> tx_buffer(length + 1, 0x00);
-  std::vector<uint8_t> rx_buffer(length + 1);
-  int8_t result = 0;
-
-  /*
-   * TODO:
-   * Implement write
-   * - The register address is received via the 'slaveAddress' parameter
-   * - The transaction needs a tx buffer with the read address and dummy bytes.
-   * - The total length of the SPI transaction is the data length + 1 byte for the address
-   * - The rx buffer will store the received data.
-   */
-
-
-  if (result == 0) {
-    // Copy the received data (skipping the first dummy byte).
-    std::memcpy(buf, rx_buffer.data() + 1, length);
-  }
-  return result;
+  // The register address is followed by dummy bytes, the reply skips the
+  // address byte. The address is sent as given (the caller sets the read bit).
+  SPITransaction t;
+  t.readReg(slaveAddress, buf, length);
+  if (t.ok())
+    t.buf_[t.seg_[0].offset] = slaveAddress;
+  return submit(t);
 }
 
 void SPIDriver::spi_delayMicroseconds(uint32_t ms) {
-  // ... (Your delay implementation) ...
+  std::this_thread::sleep_for(std::chrono::microseconds(ms));
 }
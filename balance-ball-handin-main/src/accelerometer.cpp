@@ -1,97 +1,224 @@
 #include <cstdint>
 #include <cstring>
+#include <cmath>
 #include <thread>
 #include <iostream>
 #include <algorithm>
-#include <unistd.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <fcntl.h>
-#include <sys/ioctl.h>
 #include "broker.hpp"
 #include "accelerometer.hpp"
 
-// Initialize SPI bus
-void Accelerometer::initSPI(std::string path_name) {
-    /*
-     * TODO: See exercise text
-     */
-}
-
 // Read from register
 int Accelerometer::readReg(uint8_t reg, uint8_t nbytes) {
-    /*
-     * TODO: See exercise text
-     */
-  return 0; // Update this line also!!
+    if (nbytes > MAXBUFSIZE)
+        return -1;
+
+    SPITransaction t;
+    t.readReg(reg, buffer, nbytes);
+    return spi.submit(t) == 0 ? 0 : -1;
 }
 
 // Write to register
 int Accelerometer::writeReg(uint8_t reg, uint8_t data) {
-    /*
-     * TODO: See exercise text
-     */
-  return 0; // Update this line also!!
+    SPITransaction t;
+    t.writeReg(reg, data);
+    return spi.submit(t) == 0 ? 0 : -1;
+}
+
+// Read up to BMI160_FIFO_SIZE bytes into fifo in one transfer
+int Accelerometer::readBurst(uint8_t reg, uint16_t nbytes) {
+    if (nbytes > BMI160_FIFO_SIZE)
+        return -1;
+
+    SPITransaction t;
+    t.readReg(reg, fifo, nbytes);
+    return spi.submit(t) == 0 ? 0 : -1;
 }
 
 //Turn on accelerometer
 void Accelerometer::startAccel(void) {
-    /*
-     * TODO: See exercise text
-     */
+    // A rising edge on CS switches the BMI160 to SPI, the value is ignored
+    readReg(0x7F, 1);
+
+    if (writeReg(BMI160_CMD_REG, 0x11) < 0) {
+        std::cerr << "writeReg() failed\n";
+        return;
+    }
+    // Sleep to allow accelerometer to start up
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    // ODR codes 6..12 are 25 Hz..1600 Hz, normal filter mode (acc_bwp = 2)
+    int code = 6 + static_cast<int>(std::lround(std::log2(std::max(odrHz, 25) / 25.0)));
+    code = std::clamp(code, 6, 12);
+    odrHz = 25 << (code - 6);
+    writeReg(BMI160_ACC_CONF_REG, 0x20 | code);
+    filter.setSampleRate(odrHz);
+
+    if (!fusion)
+        return;
+
+    // Gyro in normal mode at the same rate (gyr_bwp = 2), it needs up to 80 ms to start
+    if (writeReg(BMI160_CMD_REG, 0x15) < 0) {
+        std::cerr << "writeReg() failed\n";
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    writeReg(BMI160_GYR_CONF_REG, 0x20 | code);
 }
 
-// Check if accelerometer data is available
-bool Accelerometer::isAccelDataAvailable(void) {
-    /*
-     * TODO: See exercise text
-     */
-    return false; // Update this line also!!
+// Buffer accelerometer (and gyro) frames in the sensor's FIFO
+void Accelerometer::startFifo(void) {
+    int maxFrames = BMI160_FIFO_SIZE / frameBytes();
+    watermarkFrames = std::clamp(watermarkFrames, 1, maxFrames);
+
+    writeReg(BMI160_FIFO_CONFIG_0, (watermarkFrames * frameBytes() + 3) / 4);
+    writeReg(BMI160_FIFO_CONFIG_1, BMI160_FIFO_ACC_EN | (fusion ? BMI160_FIFO_GYR_EN : 0));
+    writeReg(BMI160_CMD_REG, BMI160_FIFO_FLUSH);
 }
 
-// Read accelerometer data (6 bytes)
-void Accelerometer::readAccel(void) {
-    /*
-     * TODO: See exercise text
-     */
+// Signal data ready (polling) or FIFO watermark (FIFO) on INT1
+void Accelerometer::startInterrupt(void) {
+    bool fifoMode = mode == AccelMode::Fifo;
+    writeReg(BMI160_INT_OUT_CTRL, BMI160_INT1_PUSH_PULL_HIGH);
+    writeReg(BMI160_INT_MAP_1, fifoMode ? BMI160_INT1_MAP_FWM : BMI160_INT1_MAP_DRDY);
+    writeReg(BMI160_INT_EN_1, fifoMode ? BMI160_INT_FWM : BMI160_INT_DRDY);
+}
+
+// Drain all complete frames from the FIFO, returns the number of frames
+int Accelerometer::readFifo(void) {
+    if (readReg(BMI160_FIFO_LENGTH_REG, 2) < 0)
+        return -1;
+
+    int length = (buffer[0] | buffer[1] << 8) & 0x7FF;
+    if (length >= BMI160_FIFO_SIZE - frameBytes())
+        ++fifoOverruns; // full, the oldest samples have been overwritten
+
+    int frames = length / frameBytes();
+    if (frames == 0)
+        return 0;
+    if (readBurst(BMI160_FIFO_DATA_REG, frames * frameBytes()) < 0)
+        return -1;
+    return frames;
 }
 
-Accelerometer::Accelerometer(std::string path_name)
+// A frame is gyro x, y, z then accelerometer x, y, z with fusion, just the
+// accelerometer without. Same layout in the FIFO and the data registers.
+void Accelerometer::decode(const uint8_t *frames, int count)
 {
-    /* 
-     * TODO:
-     * `initSPI` and `startAccel`
-     */
+    const float gyroScale = 1 / BMI160_GYRO_SENS;
+    const float accelScale = 1 / BMI160_ACCEL_SENS;
+    const Vec3Array gyro{gyroSamples[0], gyroSamples[1], gyroSamples[2]};
+    const Vec3Array accel{accelSamples[0], accelSamples[1], accelSamples[2]};
 
-    isActive = true;
+    if (fusion) {
+        const float scales[2] = {gyroScale, accelScale};
+        const Vec3Array out[2] = {gyro, accel};
+        decodeFrames(frames, count, 2, scales, out);
+    }
+    else {
+        decodeFrames(frames, count, 1, &accelScale, &accel);
+    }
+}
+
+// Publishes decoded frame i
+void Accelerometer::publishSample(int i, std::chrono::steady_clock::time_point timestamp)
+{
+    float a[3] = {accelSamples[0][i], accelSamples[1][i], accelSamples[2][i]};
+
+    auto msg = makeMessage(topics::accl.id, AccelerometerData{a[0], a[1], a[2]});
+    msg->timestamp = timestamp;
+    Broker::getInstance().publish(std::move(msg));
+
+    if (!fusion)
+        return;
+
+    float g[3] = {gyroSamples[0][i], gyroSamples[1][i], gyroSamples[2][i]};
+    auto orientation = makeMessage(topics::orientation.id, filter.update(a, g));
+    orientation->timestamp = timestamp;
+    Broker::getInstance().publish(std::move(orientation));
+}
+
+Accelerometer::Accelerometer(SPIDriver &spi, AccelMode mode, int odrHz, int watermarkFrames, bool fusion)
+    : spi(spi), mode(mode), odrHz(odrHz), watermarkFrames(watermarkFrames), fusion(fusion)
+{
+    isActive = spi.isOpen();
+    if (!isActive)
+        return;
+
+    startAccel();
+    if (mode == AccelMode::Fifo)
+        startFifo();
+    startInterrupt();
 }
 
 Accelerometer::~Accelerometer()
 {
     isActive = false;
-    /*
-     * TODO:
-     * Close File descriptors
-     */
 }
 
 void Accelerometer::accelerometerThread()
 {
-    char buf[16];
+    auto period = std::chrono::nanoseconds(1000000000LL / odrHz);
+    if (!events || !events->isOpen())
+        events = std::make_unique<TimerEvent>(mode == AccelMode::Fifo ? period * watermarkFrames : period);
+
+    if (mode == AccelMode::Fifo)
+        fifoLoop();
+    else
+        pollingLoop();
+
+    if (fifoOverruns)
+        std::cerr << "[Accelerometer] FIFO overran " << fifoOverruns << " times\n";
+}
+
+// One transaction (status + gyro/accelerometer data) per data ready event
+void Accelerometer::pollingLoop()
+{
+    auto period = std::chrono::nanoseconds(1000000000LL / odrHz);
+    uint8_t status = 0;
+
     while (isActive)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        // Sleep until the sensor (or the fallback timer) says there's a
+        // sample. Check on timeouts too, in case an edge was missed.
+        if (events->wait(100) < 0)
+            std::this_thread::sleep_for(period);
+
+        // Status and data in one ioctl, the data is used only if it's new
+        SPITransaction t;
+        t.readReg(BMI160_STATUS_REG, &status, 1)
+         .readReg(fusion ? BMI160_GYRO_REG : BMI160_ACCEL_REG, buffer, frameBytes());
+        if (spi.submit(t) != 0 || (status & 0x80) == 0)
+            continue;
 
-        // Check if Accelerometer data is available
-        // in while loop. Sleep for 100 
-        // microseconds, if not
+        decode(buffer, 1);
+        publishSample(0, std::chrono::steady_clock::now());
+    }
+}
 
-        // Read acceleration
+// Two transfers (fill level + burst) per watermark event. The thread may
+// be late by up to a full FIFO without losing samples.
+void Accelerometer::fifoLoop()
+{
+    auto period = std::chrono::nanoseconds(1000000000LL / odrHz);
+    // Drain anyway now and then, in case an edge was missed
+    int timeoutMs = std::max(10, static_cast<int>(4 * watermarkFrames * 1000 / odrHz));
 
-        // Convert to doubles (x,y,z)
+    while (isActive)
+    {
+        if (events->wait(timeoutMs) < 0)
+            std::this_thread::sleep_for(period * watermarkFrames);
 
-        // Encode data
+        int frames = readFifo();
+        auto drained = std::chrono::steady_clock::now();
+        if (frames < 0) {
+            std::cerr << "readFifo() failed\n";
+            continue;
+        }
 
-        // Create message & publish
+        // The newest frame was sampled just before the drain, the older
+        // ones one output period apart
+        decode(fifo, frames);
+        for (int i = 0; i < frames; ++i)
+            publishSample(i, drained - period * (frames - 1 - i));
     }
 }
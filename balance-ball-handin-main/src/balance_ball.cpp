@@ -1,45 +1,138 @@
 #include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <iostream>
 #include "I2Cdriver.hpp"
 #include "SSD1306_OLED.hpp"
 #include "display.hpp"
-#include "button.hpp"
+#include "renderer.hpp"
+#include "input_thread.hpp"
+#include "SPIdriver.hpp"
 #include "accelerometer.hpp"
 #include "broker.hpp"
 #include "led.hpp"
 #include "game_control.hpp"
 #include "logger.hpp"
+#include "shm_transport.hpp"
+#include "journal.hpp"
 
 #define myOLEDwidth 128
 #define myOLEDheight 32
 #define FULLSCREEN (myOLEDwidth * (myOLEDheight / 8))
 int main(int argc, char *argv[]) {
-  I2CDriver i2cDriver;
+  I2CDriver i2cDriver("/dev/i2c-1"); // *** IMPORTANT: CHANGE IF YOUR BUS IS DIFFERENT ***
   SSD1306 oled(myOLEDwidth, myOLEDheight, i2cDriver);
   uint8_t screenBuffer[FULLSCREEN];
   if (!oled.OLEDSetBufferPtr(myOLEDwidth, myOLEDheight, screenBuffer, sizeof(screenBuffer)))
   return -1;
+  // The library sends its init sequence a command at a time, as one batch
+  i2cDriver.beginBatch();
   oled.OLEDbegin(0x3c); // initialize the OLED
+  i2cDriver.flush();
 
-  Display display(oled);
+  Display display(i2cDriver, screenBuffer);
+  Renderer renderer(display);
 
   // Create and add consumers to Broker
-  auto gameCtrl = std::make_shared<GameControl>(display);
-  Broker::getInstance().subscribe("accl", gameCtrl);
-  Broker::getInstance().subscribe("btn", gameCtrl);
+  // GameControl gets its own delivery thread, so the accelerometer thread
+  // never waits for game logic. Messages only update the latest tilt and
+  // reset the game; the ball moves on GameControl's fixed-step physics
+  // thread, which hands each step to the render thread and publishes the
+  // boundary state when it changes. The button topic is high priority and
+  // overtakes queued sensor data.
+  SubscriptionOptions gameOptions;
+  gameOptions.mode = DeliveryMode::Latest;
 
+  auto gameCtrl = std::make_shared<GameControl>(renderer);
+  Broker::getInstance().subscribe(topics::orientation, gameCtrl, gameOptions);
+  Broker::getInstance().subscribe(topics::btn, gameCtrl, gameOptions);
+
+  // The logger prints every message to stdout. The sensor topics publish
+  // at 400 Hz and would flood it, so it only gets the input and game
+  // topics; subscribe it to "sensor/#" as well to watch the raw samples.
   auto logger = std::make_shared<Logger>();
-  Broker::getInstance().subscribe("btn", logger);
+  Broker::getInstance().subscribe("input/#", logger);
+  Broker::getInstance().subscribe("game/#", logger);
+
+  // balance_ball [--record <file>] [--metrics <seconds>] [--accel-int <line>] [--fps <n>]
+  //   --record     journals every message for journal_replay
+  //   --metrics    prints broker counters and latencies, the display's
+  //                bytes per frame and the I2C syscalls and bus time per
+  //                frame to stderr periodically
+  //   --accel-int  gpiochip0 line wired to the BMI160 INT1 pin, without it
+  //                the accelerometer is sampled on a timer
+  //   --fps        frame rate cap of the render thread (default 30)
+  std::shared_ptr<JournalWriter> journal;
+  int accelIntLine = -1;
+  int metricsSeconds = 0;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--record") == 0) {
+      journal = std::make_shared<JournalWriter>(argv[i + 1]);
+      if (journal->isOpen())
+        Broker::getInstance().subscribe("#", journal);
+    }
+    else if (std::strcmp(argv[i], "--metrics") == 0) {
+      metricsSeconds = std::atoi(argv[i + 1]);
+      Broker::getInstance().reportMetrics(std::chrono::seconds(metricsSeconds));
+    }
+    else if (std::strcmp(argv[i], "--accel-int") == 0) {
+      accelIntLine = std::atoi(argv[i + 1]);
+    }
+    else if (std::strcmp(argv[i], "--fps") == 0) {
+      renderer.setMaxFps(std::atoi(argv[i + 1]));
+    }
+  }
+
+  // Export everything to shared memory for out-of-process consumers (shm_logger).
+  // The ring has a single writer, so one delivery thread feeds it; a slow
+  // export drops its oldest queued messages rather than stall publishers.
+  auto shmPublisher = std::make_shared<ShmPublisher>("/balance_ball");
+  if (shmPublisher->isOpen()) {
+    SubscriptionOptions shmOptions;
+    shmOptions.mode = DeliveryMode::Async;
+    shmOptions.queueDepth = 1024;
+    shmOptions.overflow = OverflowPolicy::DropOldest;
+    Broker::getInstance().subscribe("#", shmPublisher, shmOptions);
+  }
 
   // Create Publishers
-  Accelerometer accl("/dev/spidev0.0");
-  Button but27("/dev/my_gpio-btn", 27);
+  SPIDriver spi("/dev/spidev0.0");
+  Accelerometer accl(spi);
+  if (accelIntLine >= 0)
+    accl.setEventSource(std::make_unique<GpioLineEvent>("/dev/gpiochip0", accelIntLine));
+
+  // All buttons share one thread. More go on their own topics, e.g.
+  //   auto btn17 = Broker::getInstance().registerTopic<ButtonData>("input/btn/17");
+  //   auto button = std::make_unique<Button>(path, 17, btn17);
+  //   input.add(button);
+  InputThread input;
+  auto btn27 = std::make_unique<Button>("/dev/my_gpio-btn", 27);
+  std::thread t3;
+  if (!input.add(btn27) && btn27->isOpen()) {
+    // The driver can't be polled (epoll_ctl fails with EPERM), read it
+    // on a thread of its own instead
+    std::cerr << "Button 27 can't be polled, reading it on its own thread" << std::endl;
+    t3 = std::thread([button = std::move(btn27)]() { button->readLoop(); });
+  }
 
   // Start Publisher threads
   std::thread t1([&accl]() { accl.accelerometerThread(); });
-  std::thread t2([&but27]() { but27.ButtonThread();});
+  std::thread t2([&input]() { input.run(); });
+
+  // Nothing else to do on the main thread
+  while (metricsSeconds > 0) {
+    std::this_thread::sleep_for(std::chrono::seconds(metricsSeconds));
+    display.stats().print(std::cerr);
+    renderer.stats().print(std::cerr);
+    i2cDriver.stats().print(std::cerr);
+  }
 
   t1.join();
   t2.join();
+  if (t3.joinable())
+    t3.join();
  
   //oled.OLEDPowerDown();
 
@@ -11,12 +11,209 @@
 #include <chrono>
 #include "broker.hpp"
 
+// ------------------------------
+// SubscriberTable
+// ------------------------------
+void SubscriberTable::resolve(TopicId topic)
+{
+    subscribers[topic].clear();
+    patterns.match(names[topic], subscribers[topic]);
+}
+
+void SubscriberTable::resolveAll()
+{
+    for (TopicId id = 0; id < names.size(); ++id)
+        resolve(id);
+}
+
 // ------------------------------
 // Broker (Thread-Safe Singleton)
 // ------------------------------
-void Broker::subscribe(const std::string& topic, std::shared_ptr<IConsumer> consumer) {
+Broker::Broker()
+{
+    auto initial = new SubscriberTable;
+    initial->names.assign(topics::names.begin(), topics::names.end());
+    initial->priorities.assign(topics::priorities.begin(), topics::priorities.end());
+    initial->subscribers.resize(initial->names.size());
+    table.store(initial);
+
+    janitor = std::thread([this]() { janitorThread(); });
+}
+
+Broker::~Broker()
+{
+    stopReporter();
+
+    running = false;
+    wakeJanitor();
+    janitor.join();
+
+    // No publishers are left, so everything can go at once
+    for (auto old : retired)
+        delete old;
+
+    auto current = const_cast<SubscriberTable*>(table.load());
+    current->patterns.removeAll([](const Subscription& sub) {
+        if (sub.dispatcher)
+            sub.dispatcher->stop();
+        return true;
+    });
+    delete current;
+}
+
+// ------------------------------
+// Read side
+// ------------------------------
+uint32_t Broker::readLock()
+{
+    uint32_t e = epoch.load() & 1;
+    readers[e].fetch_add(1);
+    return e;
+}
+
+void Broker::readUnlock(uint32_t e)
+{
+    readers[e].fetch_sub(1);
+}
+
+// ------------------------------
+// Write side
+// ------------------------------
+void Broker::update(const std::function<void(SubscriberTable&)>& modify)
+{
     std::lock_guard<std::mutex> lock(mtx);
-    subscribers[topic].push_back(consumer);
+
+    const SubscriberTable* old = table.load();
+    auto next = new SubscriberTable(*old);
+    modify(*next);
+    table.store(next);
+
+    // Publishers may still be iterating the old table, let the janitor free it
+    retired.push_back(old);
+    wakeJanitor();
+}
+
+void Broker::waitForReaders()
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        uint32_t old = epoch.fetch_add(1) & 1;
+        while (readers[old].load() != 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void Broker::wakeJanitor()
+{
+    janitorSignal.fetch_add(1);
+    janitorSignal.notify_one();
+}
+
+void Broker::janitorThread()
+{
+    while (running)
+    {
+        uint32_t seen = janitorSignal.load();
+
+        if (pruneRequested.exchange(false)) {
+            update([](SubscriberTable& t) {
+                t.patterns.removeAll([](const Subscription& sub) { return sub.consumer.expired(); });
+                t.resolveAll();
+            });
+        }
+
+        std::vector<const SubscriberTable*> reclaim;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            reclaim.swap(retired);
+        }
+        if (!reclaim.empty()) {
+            waitForReaders();
+            for (auto old : reclaim)
+                delete old;
+        }
+
+        if (janitorSignal.load() == seen)
+            janitorSignal.wait(seen);
+    }
+}
+
+// ------------------------------
+// Public API
+// ------------------------------
+void Broker::subscribe(std::string_view pattern, std::shared_ptr<IConsumer> consumer,
+                       const SubscriptionOptions& options) {
+    if (!TopicTrie<Subscription>::valid(pattern)) {
+        std::cerr << "[Broker] Invalid topic pattern: " << pattern << "\n";
+        return;
+    }
+
+    update([&](SubscriberTable& t) {
+        Subscription sub{consumer, nullptr};
+
+        // Reuse the consumer's delivery thread for the same options so its
+        // lanes see all those topics, and its metrics id so its onMessage
+        // time is counted once
+        t.patterns.forEachValue([&](const Subscription& other) {
+            if (other.consumer.lock() != consumer)
+                return;
+            sub.metricsId = other.metricsId;
+            if (other.dispatcher && options.mode != DeliveryMode::Sync && other.dispatcher->accepts(options))
+                sub.dispatcher = other.dispatcher;
+        });
+        if (sub.metricsId == BrokerMetrics::noConsumer)
+            sub.metricsId = BrokerMetrics::getInstance().registerConsumer(*consumer);
+
+        if (options.mode != DeliveryMode::Sync && !sub.dispatcher) {
+            sub.dispatcher = std::make_shared<Dispatcher>(consumer, options, sub.metricsId);
+            sub.dispatcher->start();
+        }
+
+        t.patterns.insert(pattern, std::move(sub));
+        t.resolveAll();
+    });
+}
+
+TopicId Broker::registerTopic(std::string_view name, Priority priority)
+{
+    if (!TopicTrie<Subscription>::concrete(name)) {
+        std::cerr << "[Broker] Invalid topic name: " << name << "\n";
+        return invalidTopic;
+    }
+
+    TopicId id = invalidTopic;
+    update([&](SubscriberTable& t) {
+        for (TopicId i = 0; i < t.names.size(); ++i)
+            if (t.names[i] == name)
+                id = i;
+        if (id != invalidTopic || t.names.size() >= invalidTopic)
+            return;
+
+        // Names are never freed, Topic<> and snapshots keep views of them
+        id = static_cast<TopicId>(t.names.size());
+        t.names.push_back(topicNames.emplace_back(name));
+        t.priorities.push_back(priority);
+        t.subscribers.emplace_back();
+        t.resolve(id);
+    });
+    return id;
+}
+
+void Broker::setPriority(TopicId topic, Priority priority)
+{
+    update([&](SubscriberTable& t) {
+        if (topic < t.priorities.size())
+            t.priorities[topic] = priority;
+    });
+}
+
+std::string_view Broker::topicName(TopicId topic)
+{
+    uint32_t e = readLock();
+    const SubscriberTable* current = table.load();
+    std::string_view name = topic < current->names.size() ? current->names[topic] : "?";
+    readUnlock(e);
+    return name;
 }
 
 // Weak Pointer solution (solution) (Not thread safe!!)
@@ -44,56 +241,135 @@ void Broker::subscribe(const std::string& topic, std::shared_ptr<IConsumer> cons
 //     }
 // }
 
-void Broker::publish(std::unique_ptr<Message> msg)
+void Broker::publish(MessagePtr msg)
 {
-    std::vector<std::weak_ptr<IConsumer>> copiedSubscribers;
+    BrokerMetrics& metrics = BrokerMetrics::getInstance();
+    metrics.published(msg->topic);
 
-    {
-        std::lock_guard<std::mutex> lock(mtx);
+    uint32_t e = readLock();
+    const SubscriberTable* current = table.load();
 
-        auto it = subscribers.find(msg->topic);
-        if (it == subscribers.end()) {
-            std::cout << "[Broker] No subscribers for topic: " << msg->topic << "\n";
-            return;
-        }
+    if (msg->topic >= current->subscribers.size() || current->subscribers[msg->topic].empty()) {
+        readUnlock(e);
+        metrics.unrouted(msg->topic);
+        return;
+    }
 
-        // Copy list of subscribers
-        copiedSubscribers = it->second;
-    } // <-- mutex unlocks here
+    // Async subscribers share ownership of the message with their mailboxes
+    MessageRef shared;
+    Priority priority = current->priorities[msg->topic];
+    bool expired = false;
 
-    // Now it's safe to call into user code
-    for (auto& subscriberWeak : copiedSubscribers)
+    // The snapshot is immutable, so it's safe to call into user code
+    for (auto& sub : current->subscribers[msg->topic])
     {
-        if (auto consumer = subscriberWeak.lock())
-            consumer->onMessage(*msg);  // no lock held
+        if (sub.consumer.expired()) {
+            // Also for async subscribers, whose delivery thread has stopped
+            metrics.expired(shared ? shared->topic : msg->topic);
+            expired = true;
+        }
+        else if (sub.dispatcher) {
+            if (!shared)
+                shared = MessageRef(std::move(msg));
+            sub.dispatcher->post(shared, priority);
+        }
+        else if (auto consumer = sub.consumer.lock()) {
+            metrics.deliver(*consumer, shared ? *shared : *msg, sub.metricsId);  // no lock held
+        }
+        else {
+            metrics.expired(shared ? shared->topic : msg->topic);
+            expired = true;
+        }
     }
+    readUnlock(e);
+
+    // Leave the cleanup to the janitor, only signal it once
+    if (expired && !pruneRequested.exchange(true))
+        wakeJanitor();
 }
 
+void Broker::unsubscribe(std::string_view pattern, std::shared_ptr<IConsumer> consumer) 
+{
+    update([&](SubscriberTable& t) {
+        // Erase IConsumer from the pattern
+        std::shared_ptr<Dispatcher> dispatcher;
+        t.patterns.remove(pattern, [&](const Subscription& sub) {
+            if (sub.consumer.lock() != consumer)
+                return false;
+            dispatcher = sub.dispatcher;
+            return true;
+        });
 
+        // Stop its delivery thread unless other subscriptions still use it
+        t.patterns.forEachValue([&](const Subscription& sub) {
+            if (sub.dispatcher == dispatcher)
+                dispatcher.reset();
+        });
+        if (dispatcher)
+            dispatcher->stop();
 
-void Broker::unsubscribe(const std::string& topic, std::shared_ptr<IConsumer> consumer) 
+        t.resolveAll();
+    });
+}
+
+MetricsSnapshot Broker::metrics()
 {
-    {
-        std::lock_guard<std::mutex> lock(mtx);
+    uint32_t e = readLock();
+    const SubscriberTable* current = table.load();
 
-        // Look up Topic in subscribers
-        auto subscribers_it = subscribers.find(topic);
-        if (subscribers_it == subscribers.end()) {
-            // Topic not found
-            return;
-        }
+    MetricsSnapshot snap = BrokerMetrics::getInstance().snapshot(current->names.size());
+    for (auto& t : snap.topics)
+        t.name = current->names[t.topic]; // names are never freed
 
-        // Erase IConsumer from topic
-        for (auto consumer_it = subscribers_it->second.begin(); consumer_it != subscribers_it->second.end();) 
-        {
-            if(consumer_it->lock() == consumer)
-                consumer_it = subscribers_it->second.erase(consumer_it);
+    readUnlock(e);
+    return snap;
+}
 
-        }
+void Broker::reportMetrics(std::chrono::milliseconds interval, std::ostream& out)
+{
+    stopReporter();
+    if (interval.count() <= 0)
+        return;
+
+    reporting = true;
+    reporter = std::thread([this, interval, &out]() {
+        std::unique_lock<std::mutex> lock(reporterMtx);
+        while (!reporterCv.wait_for(lock, interval, [this]() { return !reporting; }))
+            metrics().print(out);
+    });
+}
 
-        // Erase topic if empty
-        if (subscribers_it->second.size() == 0) // if IConsumer.size == 0
-            subscribers_it = subscribers.erase(subscribers_it);
+void Broker::stopReporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(reporterMtx);
+        reporting = false;
     }
+    reporterCv.notify_all();
+    if (reporter.joinable())
+        reporter.join();
 }
 
+std::size_t Broker::subscriberCount(TopicId topic)
+{
+    uint32_t e = readLock();
+    const SubscriberTable* current = table.load();
+    std::size_t n = topic < current->subscribers.size() ? current->subscribers[topic].size() : 0;
+    readUnlock(e);
+    return n;
+}
+
+SubscriptionStats Broker::stats(std::string_view pattern, std::shared_ptr<IConsumer> consumer)
+{
+    SubscriptionStats result;
+    uint32_t e = readLock();
+    const SubscriberTable* current = table.load();
+
+    current->patterns.forEach(pattern, [&](const Subscription& sub) {
+        if (sub.dispatcher && sub.consumer.lock() == consumer)
+            result = sub.dispatcher->stats();
+    });
+
+    readUnlock(e);
+    return result;
+}
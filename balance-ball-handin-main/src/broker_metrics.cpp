@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <iomanip>
+#include <typeinfo>
+#include "broker_metrics.hpp"
+
+namespace {
+
+// Only the owning thread writes, so a plain load + store is enough
+inline void bump(std::atomic<uint64_t> &counter, uint64_t n = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+std::string className(const IConsumer &consumer)
+{
+    const char *mangled = typeid(consumer).name();
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    std::string name = status == 0 ? demangled : mangled;
+    std::free(demangled);
+    return name;
+}
+
+// Microseconds with one decimal
+struct Us {
+    uint64_t ns;
+};
+
+std::ostream &operator<<(std::ostream &out, Us us)
+{
+    return out << us.ns / 1000 << '.' << (us.ns % 1000) / 100;
+}
+
+} // namespace
+
+// ------------------------------
+// Histograms
+// ------------------------------
+int HistogramSnapshot::bucketOf(uint64_t ns)
+{
+    if (ns < subBuckets)
+        return static_cast<int>(ns);
+    ns = std::min<uint64_t>(ns, (uint64_t(1) << maxBits) - 1);
+    int shift = std::bit_width(ns) - 1 - subBits;
+    return (shift + 1) * subBuckets + static_cast<int>((ns >> shift) & (subBuckets - 1));
+}
+
+uint64_t HistogramSnapshot::lowerBound(int bucket)
+{
+    if (bucket < subBuckets)
+        return bucket;
+    int shift = bucket / subBuckets - 1;
+    return uint64_t(subBuckets + bucket % subBuckets) << shift;
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot &other)
+{
+    for (int i = 0; i < buckets; ++i)
+        counts[i] += other.counts[i];
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const
+{
+    if (count == 0)
+        return 0;
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * count + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < buckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::min(max, i + 1 < buckets ? lowerBound(i + 1) - 1 : max);
+    }
+    return max;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    bump(counts[HistogramSnapshot::bucketOf(ns)]);
+    bump(count);
+    bump(sum, ns);
+    if (ns > max.load(std::memory_order_relaxed))
+        max.store(ns, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::addTo(HistogramSnapshot &out) const
+{
+    for (int i = 0; i < HistogramSnapshot::buckets; ++i)
+        out.counts[i] += counts[i].load(std::memory_order_relaxed);
+    out.count += count.load(std::memory_order_relaxed);
+    out.sum += sum.load(std::memory_order_relaxed);
+    out.max = std::max(out.max, max.load(std::memory_order_relaxed));
+}
+
+// ------------------------------
+// Shards
+// ------------------------------
+BrokerMetrics::Shard *BrokerMetrics::acquireShard()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto &shard : shards) {
+        if (!shard.inUse.load(std::memory_order_acquire)) {
+            shard.inUse.store(true, std::memory_order_relaxed);
+            return &shard;
+        }
+    }
+    return &shards.emplace_back();
+}
+
+BrokerMetrics::Shard &BrokerMetrics::local()
+{
+    // Gives the shard back when the thread exits
+    struct Lease {
+        Shard *shard = nullptr;
+        ~Lease() {
+            if (shard)
+                shard->inUse.store(false, std::memory_order_release);
+        }
+    };
+    thread_local Lease lease;
+
+    if (!lease.shard)
+        lease.shard = acquireShard();
+    return *lease.shard;
+}
+
+// ------------------------------
+// Recording
+// ------------------------------
+uint32_t BrokerMetrics::registerConsumer(const IConsumer &consumer)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    consumerNames.push_back(className(consumer));
+    return static_cast<uint32_t>(consumerNames.size() - 1);
+}
+
+void BrokerMetrics::published(TopicId id)
+{
+    if (!isEnabled())
+        return;
+    if (auto t = topic(id))
+        bump(t->published);
+}
+
+void BrokerMetrics::unrouted(TopicId id)
+{
+    if (!isEnabled())
+        return;
+    if (auto t = topic(id))
+        bump(t->unrouted);
+}
+
+void BrokerMetrics::dropped(TopicId id)
+{
+    if (!isEnabled())
+        return;
+    if (auto t = topic(id))
+        bump(t->dropped);
+}
+
+void BrokerMetrics::coalesced(TopicId id)
+{
+    if (!isEnabled())
+        return;
+    if (auto t = topic(id))
+        bump(t->coalesced);
+}
+
+void BrokerMetrics::expired(TopicId id)
+{
+    if (!isEnabled())
+        return;
+    if (auto t = topic(id))
+        bump(t->expired);
+}
+
+void BrokerMetrics::deliver(IConsumer &consumer, const Message &msg, uint32_t consumerId)
+{
+    if (!isEnabled()) {
+        consumer.onMessage(msg);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    consumer.onMessage(msg);
+    auto end = std::chrono::steady_clock::now();
+
+    auto ns = [](auto d) {
+        auto n = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        return static_cast<uint64_t>(std::max<decltype(n)>(n, 0));
+    };
+
+    Shard &shard = local();
+    if (auto t = shard.topics.at(msg.topic)) {
+        bump(t->delivered);
+        t->dispatchLatency.record(ns(start - msg.timestamp));
+    }
+    if (consumerId != noConsumer) {
+        if (auto c = shard.consumers.at(consumerId)) {
+            bump(c->delivered);
+            c->onMessage.record(ns(end - start));
+        }
+    }
+}
+
+// ------------------------------
+// Reading
+// ------------------------------
+MetricsSnapshot BrokerMetrics::snapshot(std::size_t topicCount)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    MetricsSnapshot snap;
+    snap.topics.resize(std::min<std::size_t>(topicCount, maxIds));
+    snap.consumers.resize(std::min<std::size_t>(consumerNames.size(), maxIds));
+
+    for (uint32_t id = 0; id < snap.topics.size(); ++id)
+        snap.topics[id].topic = static_cast<TopicId>(id);
+    for (uint32_t id = 0; id < snap.consumers.size(); ++id) {
+        snap.consumers[id].id = id;
+        snap.consumers[id].name = consumerNames[id];
+    }
+
+    for (auto &shard : shards) {
+        for (uint32_t id = 0; id < snap.topics.size(); ++id) {
+            const TopicCounters *t = shard.topics.find(id);
+            if (!t)
+                continue;
+            auto &out = snap.topics[id];
+            out.published += t->published.load(std::memory_order_relaxed);
+            out.delivered += t->delivered.load(std::memory_order_relaxed);
+            out.dropped += t->dropped.load(std::memory_order_relaxed);
+            out.coalesced += t->coalesced.load(std::memory_order_relaxed);
+            out.expired += t->expired.load(std::memory_order_relaxed);
+            out.unrouted += t->unrouted.load(std::memory_order_relaxed);
+            t->dispatchLatency.addTo(out.dispatchLatency);
+        }
+        for (uint32_t id = 0; id < snap.consumers.size(); ++id) {
+            const ConsumerCounters *c = shard.consumers.find(id);
+            if (!c)
+                continue;
+            snap.consumers[id].delivered += c->delivered.load(std::memory_order_relaxed);
+            c->onMessage.addTo(snap.consumers[id].onMessage);
+        }
+    }
+    return snap;
+}
+
+void MetricsSnapshot::print(std::ostream &out) const
+{
+    auto flags = out.flags();
+    out << std::left << std::setw(20) << "[Metrics] topic" << std::right
+        << std::setw(10) << "published" << std::setw(10) << "delivered" << std::setw(9) << "dropped"
+        << std::setw(10) << "coalesced" << std::setw(9) << "expired" << std::setw(10) << "unrouted"
+        << "   latency us p50 / p99 / p99.9 / max\n";
+    for (auto &t : topics) {
+        if (!t.published && !t.delivered)
+            continue;
+        auto &h = t.dispatchLatency;
+        out << std::left << std::setw(20) << t.name << std::right
+            << std::setw(10) << t.published << std::setw(10) << t.delivered << std::setw(9) << t.dropped
+            << std::setw(10) << t.coalesced << std::setw(9) << t.expired << std::setw(10) << t.unrouted
+            << "   " << Us{h.percentile(0.5)} << " / " << Us{h.percentile(0.99)} << " / "
+            << Us{h.percentile(0.999)} << " / " << Us{h.max} << "\n";
+    }
+
+    out << std::left << std::setw(20) << "[Metrics] consumer" << std::right << std::setw(10) << "delivered"
+        << "   onMessage us p50 / p99 / p99.9 / max\n";
+    for (auto &c : consumers) {
+        if (!c.delivered)
+            continue;
+        auto &h = c.onMessage;
+        out << std::left << std::setw(20) << (c.name + "#" + std::to_string(c.id)) << std::right
+            << std::setw(10) << c.delivered
+            << "   " << Us{h.percentile(0.5)} << " / " << Us{h.percentile(0.99)} << " / "
+            << Us{h.percentile(0.999)} << " / " << Us{h.max} << "\n";
+    }
+    out.flags(flags);
+}
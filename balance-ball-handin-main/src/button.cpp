@@ -1,45 +1,107 @@
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <cerrno>
 #include <thread>
-#include <iostream>
 #include "broker.hpp"
 #include "button.hpp"
 
-Button::Button(std::string path_name, int gpio) : gpio(gpio)
+Button::Button(const std::string &path_name, int gpio, Topic<ButtonData> topic, std::chrono::milliseconds debounce)
+    : gpio(gpio), topic(topic.id), debounce(debounce)
 {
-    /*
-     * TODO: 
-     * Request GPIO Inputs
-     * - Open gpio device
-     */
+    fd = open(path_name.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        perror("open()");
+}
 
-    isActive = true;
+Button::Button(int fd, int gpio, Topic<ButtonData> topic, std::chrono::milliseconds debounce)
+    : fd(fd), gpio(gpio), topic(topic.id), debounce(debounce)
+{
+    // readInput() must never block the input thread
+    if (fd >= 0)
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
 }
 
 Button::~Button()
 {
-    isActive = false;
-    /*
-     * Close File descriptors
-     */
+    if (fd >= 0)
+        close(fd);
 }
 
-void Button::ButtonThread()
+int Button::readInput(Clock::time_point now)
 {
-    while (isActive)
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    // One read per wakeup: a pipe may hold several levels, a device node
+    // returns the current one
+    char data[64];
+    ssize_t n = read(fd, data, sizeof(data));
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return 0;
+        perror("read()");
+        return -1;
+    }
+    if (n == 0)
+        return -1;
 
-        /*
-         * TODO:
-         * Read value from button device node (Posix)
-         * Encode value to message data string
-         * Create a message
-         * Publish the message
-         */
+    int levels = 0;
+    for (ssize_t i = 0; i < n; ++i) {
+        int level = data[i] >= '0' ? data[i] - '0' : data[i];
+        if (level != 0 && level != 1)
+            continue; // newlines
+        onLevel(level, now);
+        ++levels;
+    }
+    return levels;
+}
+
+void Button::onLevel(int level, Clock::time_point now)
+{
+    raw = level;
+    if (settling || level == published)
+        return;
+
+    publish(level, now);
+    settling = true;
+    quietAt = now + debounce;
+}
+
+void Button::settle(Clock::time_point now)
+{
+    if (!settling || now < quietAt)
+        return;
 
+    settling = false;
+    if (raw != published) {
+        // Changed back while bouncing, that is a real edge as well
+        publish(raw, now);
+        settling = true;
+        quietAt = now + debounce;
     }
 }
+
+Button::Clock::time_point Button::deadline() const
+{
+    return settling ? quietAt : Clock::time_point::max();
+}
+
+void Button::readLoop(std::chrono::milliseconds period)
+{
+    // A level each period, shorter than the debounce window so settle()
+    // still runs close to its deadline
+    while (isActive)
+    {
+        auto now = Clock::now();
+        if (readInput(now) < 0)
+            return;
+        settle(now);
+        std::this_thread::sleep_for(period);
+    }
+}
+
+void Button::publish(int level, Clock::time_point timestamp)
+{
+    published = level;
+    auto msg = makeMessage(topic, ButtonData{gpio, level});
+    msg->timestamp = timestamp;
+    Broker::getInstance().publish(std::move(msg));
+}
@@ -0,0 +1,220 @@
+#include <bit>
+#include "dispatcher.hpp"
+
+Dispatcher::Dispatcher(std::weak_ptr<IConsumer> consumer, const SubscriptionOptions &options,
+                       uint32_t metricsId)
+    : consumer(std::move(consumer)), metricsId(metricsId), options(options),
+      conflate(options.mode == DeliveryMode::Latest),
+      urgent(options.queueDepth), mailbox(conflate ? 1 : options.queueDepth)
+{
+    if (conflate) {
+        latest = std::make_unique<std::atomic<LatestSlots*>[]>(latestGroups);
+        latestReady = std::make_unique<std::atomic<uint64_t>[]>(latestGroups);
+    }
+}
+
+Dispatcher::~Dispatcher()
+{
+    for (std::size_t g = 0; conflate && g < latestGroups; ++g) {
+        LatestSlots *slots = latest[g].load();
+        if (!slots)
+            continue;
+        for (auto &slot : slots->slot)
+            MessageRef::adopt(slot.exchange(nullptr));
+        delete slots;
+    }
+}
+
+void Dispatcher::start()
+{
+    std::thread([self = shared_from_this()]() { self->deliveryThread(); }).detach();
+}
+
+void Dispatcher::stop()
+{
+    running = false;
+    pushed.fetch_add(1);
+    pushed.notify_all();
+    popped.fetch_add(1);
+    popped.notify_all();
+}
+
+void Dispatcher::post(MessageRef msg, Priority priority)
+{
+    if (priority == Priority::High) {
+        enqueue(urgent, std::move(msg));
+        return;
+    }
+
+    if (conflate) {
+        // Overwrite whatever the consumer has not picked up yet of this topic
+        TopicId topic = msg->topic;
+        if (auto previous = latestSlots(topic)->slot[topic % 64].exchange(msg.release())) {
+            BrokerMetrics::getInstance().coalesced(previous->topic);
+            MessageRef::adopt(previous);
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        latestReady[topic / 64].fetch_or(uint64_t(1) << (topic % 64));
+        pushed.fetch_add(1);
+        pushed.notify_one();
+        return;
+    }
+
+    enqueue(mailbox, std::move(msg));
+}
+
+void Dispatcher::enqueue(Mailbox<MessageRef>& lane, MessageRef msg)
+{
+    while (!lane.tryPush(std::move(msg)))
+    {
+        if (options.overflow == OverflowPolicy::DropNewest) {
+            BrokerMetrics::getInstance().dropped(msg->topic);
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (options.overflow == OverflowPolicy::DropOldest) {
+            MessageRef oldest;
+            if (lane.tryPop(oldest)) {
+                BrokerMetrics::getInstance().dropped(oldest->topic);
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        // Block: wait for the delivery thread to free a slot
+        uint32_t seen = popped.load();
+        if (!running)
+            return;
+        if (lane.size() >= lane.capacity())
+            popped.wait(seen);
+    }
+
+    pushed.fetch_add(1);
+    pushed.notify_one();
+}
+
+Dispatcher::LatestSlots *Dispatcher::latestSlots(TopicId topic)
+{
+    std::size_t group = topic / 64;
+    LatestSlots *slots = latest[group].load();
+    if (slots)
+        return slots;
+
+    // First message to one of these 64 topics. The delivery thread scans
+    // up to latestUsed, raise it before the slot can fill.
+    std::size_t used = latestUsed.load();
+    while (used <= group && !latestUsed.compare_exchange_weak(used, group + 1))
+        ;
+    auto fresh = new LatestSlots;
+    if (latest[group].compare_exchange_strong(slots, fresh))
+        return fresh;
+    delete fresh; // another publisher was first
+    return slots;
+}
+
+// Round robin over the full slots, starting after the topic delivered
+// last, so a fast topic can't starve the others
+bool Dispatcher::takeLatest(MessageRef& msg)
+{
+    std::size_t groups = latestUsed.load();
+    if (groups == 0)
+        return false;
+    if (latestNext >= groups * 64)
+        latestNext = 0;
+
+    std::size_t start = latestNext / 64;
+    uint64_t after = ~uint64_t(0) << (latestNext % 64);
+    for (std::size_t i = 0; i <= groups; ++i) {
+        std::size_t group = (start + i) % groups;
+        uint64_t ready = latestReady[group].load();
+        if (i == 0)
+            ready &= after;
+        else if (i == groups)
+            ready &= ~after;
+
+        while (ready) {
+            int bit = std::countr_zero(ready);
+            ready &= ready - 1;
+            // Clear the bit before emptying the slot: a publish that finds
+            // the slot empty sets it again
+            latestReady[group].fetch_and(~(uint64_t(1) << bit));
+            const Message* m = latest[group].load()->slot[bit].exchange(nullptr);
+            if (m) {
+                latestNext = group * 64 + bit + 1;
+                msg = MessageRef::adopt(m);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Dispatcher::take(MessageRef& msg)
+{
+    if (urgent.tryPop(msg)) {
+        auto waited = std::chrono::steady_clock::now() - msg->timestamp;
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count();
+        highDelivered.fetch_add(1, std::memory_order_relaxed);
+        highWaitTotalNs.fetch_add(ns, std::memory_order_relaxed);
+        if (ns > highWaitMaxNs.load(std::memory_order_relaxed))
+            highWaitMaxNs.store(ns, std::memory_order_relaxed); // only this thread writes it
+    }
+    else if (conflate) {
+        return takeLatest(msg);
+    }
+    else if (!mailbox.tryPop(msg)) {
+        return false;
+    }
+
+    popped.fetch_add(1);
+    popped.notify_all();
+    return true;
+}
+
+void Dispatcher::deliveryThread()
+{
+    MessageRef msg;
+    while (running)
+    {
+        uint32_t seen = pushed.load();
+        if (!take(msg)) {
+            pushed.wait(seen);
+            continue;
+        }
+
+        auto c = consumer.lock();
+        if (!c) {
+            // Consumer is gone, nothing left to deliver to
+            BrokerMetrics::getInstance().expired(msg->topic);
+            stop();
+            break;
+        }
+        BrokerMetrics::getInstance().deliver(*c, *msg, metricsId);
+        delivered.fetch_add(1, std::memory_order_relaxed);
+        msg.reset();
+    }
+}
+
+SubscriptionStats Dispatcher::stats() const
+{
+    SubscriptionStats s;
+    s.queued = urgent.size() + mailbox.size();
+    s.capacity = urgent.capacity() + mailbox.capacity();
+    s.delivered = delivered.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    s.coalesced = coalesced.load(std::memory_order_relaxed);
+    if (conflate) {
+        s.queued = urgent.size();
+        s.capacity = urgent.capacity();
+        for (std::size_t g = 0; g < latestUsed.load(); ++g) {
+            s.queued += std::popcount(latestReady[g].load(std::memory_order_relaxed));
+            s.capacity += latest[g].load() ? 64 : 0;
+        }
+    }
+    s.highDelivered = highDelivered.load(std::memory_order_relaxed);
+    s.highWaitTotalNs = highWaitTotalNs.load(std::memory_order_relaxed);
+    s.highWaitMaxNs = highWaitMaxNs.load(std::memory_order_relaxed);
+    return s;
+}
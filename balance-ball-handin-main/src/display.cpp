@@ -1,33 +1,170 @@
 #include <thread>
 #include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
 #include "display.hpp"
-#include "bitmaps.hpp"
 #include "message.hpp"
 #include "broker.hpp"
 
 static const int ballCenterPosX = 64;
 static const int ballCenterPosY = 16;
 
-Display::Display(SSD1306 &oledRef) : oled(oledRef) {
-    oled.OLEDclearBuffer();
+// Bytes a window costs on top of its data: the command write (control
+// byte + 6 command bytes) and the data write's control byte
+static const int windowOverhead = 8;
+
+Display::Display(I2CDriver &bus, uint8_t *buffer, uint8_t address)
+    : bus(bus), buffer(buffer), address(address)
+{
+    std::memset(buffer, 0, OLED_BUFFER_SIZE);
+
+    // Windows rely on horizontal addressing: data wraps from the last
+    // column of the window to the first column of the next page
+    const uint8_t mode[] = {SSD1306_MEMORY_MODE, 0x00};
+    command(mode, sizeof(mode));
+}
+
+Display::~Display()
+{
+    // The last frame's completion still refers to this
+    bus.waitIdle();
 }
 
 void Display::drawDisplay(GameState gameState) {
     std::lock_guard<std::mutex> lock(display_mtx);
 
-    // Clear display buffer first
-    oled.OLEDclearBuffer();
+    // The buffer still holds the last frame: take the ball out, write the
+    // score over page 0 and put the ball in at its new place
+    if (ballDrawn)
+        eraseSprite(buffer, ballX, ballY, ballSprite);
+    scoreText.draw(buffer, gameState.score);
+    blitSprite(buffer, gameState.ball_x, gameState.ball_y, ballSprite);
+    ballX = gameState.ball_x;
+    ballY = gameState.ball_y;
+    ballDrawn = true;
+
+    // Send the changes to the OLED
+    flush();
+}
+
+DisplayStats Display::stats() {
+    std::lock_guard<std::mutex> lock(display_mtx);
+    return counters;
+}
+
+bool Display::command(const uint8_t *cmds, uint16_t length) {
+    uint8_t msg[8];
+    msg[0] = SSD1306_CONTROL_CMD;
+    std::memcpy(msg + 1, cmds, length);
+    ++counters.writes;
+    counters.bytes += length + 1;
+    counters.lastFrameBytes += length + 1;
+    return bus.write(address, msg, length + 1) == 0;
+}
+
+// Sets the address window and sends its bytes in one data write
+bool Display::sendWindow(int firstPage, int lastPage, int firstColumn, int lastColumn) {
+    const uint8_t window[] = {SSD1306_COLUMN_ADDR, uint8_t(firstColumn), uint8_t(lastColumn),
+                              SSD1306_PAGE_ADDR, uint8_t(firstPage), uint8_t(lastPage)};
+    if (!command(window, sizeof(window)))
+        return false;
+
+    uint8_t msg[OLED_BUFFER_SIZE + 1];
+    uint16_t length = 1;
+    msg[0] = SSD1306_CONTROL_DATA;
+    int width = lastColumn - firstColumn + 1;
+    for (int page = firstPage; page <= lastPage; ++page) {
+        std::memcpy(msg + length, buffer + page * OLED_WIDTH + firstColumn, width);
+        length += width;
+    }
+
+    ++counters.writes;
+    counters.bytes += length;
+    counters.lastFrameBytes += length;
+    return bus.write(address, msg, length) == 0;
+}
+
+void Display::flush() {
+    ++counters.frames;
+    counters.lastFrameBytes = 0;
+
+    // A failed send of an earlier frame leaves the panel's content unknown
+    if (sendFailed.exchange(false))
+        shadowValid = false;
 
-    // Draw ball
-    oled.OLEDBitmap(gameState.ball_x, gameState.ball_y, 8, 8, ballBitmap, false);
+    // Changed column span of every page, first > last if none
+    int first[OLED_PAGES], last[OLED_PAGES];
+    int dirtyPages = 0, pageCost = 0;
+    int minPage = OLED_PAGES, maxPage = -1, minColumn = OLED_WIDTH, maxColumn = -1;
+    for (int page = 0; page < OLED_PAGES; ++page) {
+        const uint8_t *now = buffer + page * OLED_WIDTH;
+        const uint8_t *was = shadow + page * OLED_WIDTH;
+        first[page] = OLED_WIDTH;
+        last[page] = -1;
+        if (shadowValid && std::memcmp(now, was, OLED_WIDTH) == 0)
+            continue;
 
-    //  Render score as text
-    oled.setTextColor(WHITE);
-    oled.setTextSize(1);
-    oled.setCursor(0, 0);
-    oled.print("Score ");
-    oled.print(gameState.score);
+        int c0 = 0, c1 = OLED_WIDTH - 1;
+        if (shadowValid) {
+            while (now[c0] == was[c0])
+                ++c0;
+            while (now[c1] == was[c1])
+                --c1;
+        }
+        first[page] = c0;
+        last[page] = c1;
+        ++dirtyPages;
+        pageCost += windowOverhead + (c1 - c0 + 1);
+        minPage = std::min(minPage, page);
+        maxPage = page;
+        minColumn = std::min(minColumn, c0);
+        maxColumn = std::max(maxColumn, c1);
+    }
+
+    if (dirtyPages == 0) {
+        ++counters.unchanged;
+        return;
+    }
+
+    // One window per page, their bounding box or everything, whichever
+    // sends the fewest bytes. The writes are queued and sent together on
+    // the driver's flush thread.
+    int boxCost = windowOverhead + (maxColumn - minColumn + 1) * (maxPage - minPage + 1);
+    int fullCost = windowOverhead + OLED_BUFFER_SIZE;
+    bool ok = true;
+    bus.beginBatch();
+    if (fullCost <= std::min(pageCost, boxCost)) {
+        ++counters.full;
+        ok = sendWindow(0, OLED_PAGES - 1, 0, OLED_WIDTH - 1);
+    }
+    else if (boxCost <= pageCost) {
+        ++counters.partial;
+        ok = sendWindow(minPage, maxPage, minColumn, maxColumn);
+    }
+    else {
+        ++counters.partial;
+        for (int page = minPage; page <= maxPage && ok; ++page)
+            if (first[page] <= last[page])
+                ok = sendWindow(page, page, first[page], last[page]);
+    }
+
+    bus.flushAsync([this](int8_t result) {
+        if (result != 0)
+            sendFailed = true;
+    });
+
+    std::memcpy(shadow, buffer, OLED_BUFFER_SIZE);
+    shadowValid = ok;
+}
 
-    // Send buffer to OLED
-    oled.OLEDupdate();
+void DisplayStats::print(std::ostream &out) const
+{
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << "[Display] frames " << frames << " (full " << full << ", partial " << partial << ", unchanged "
+        << unchanged << "), " << bytes << " bytes in " << writes << " writes, " << std::fixed
+        << std::setprecision(1) << bytesPerFrame() << " bytes/frame, last " << lastFrameBytes << "\n";
+    out.flags(flags);
+    out.precision(precision);
 }
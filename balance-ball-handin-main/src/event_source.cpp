@@ -0,0 +1,145 @@
+#include <cerrno>
+#include <cstring>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <linux/gpio.h>
+#include "event_source.hpp"
+
+// ------------------------------
+// EventSource
+// ------------------------------
+EventSource::~EventSource()
+{
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+int EventSource::wait(int timeoutMs)
+{
+    if (fd_ < 0)
+        return -1;
+
+    pollfd p{fd_, POLLIN, 0};
+    int ready = poll(&p, 1, timeoutMs);
+    if (ready < 0) {
+        if (errno == EINTR)
+            return 0;
+        perror("poll()");
+        return -1;
+    }
+    if (ready == 0)
+        return 0;
+    return consume();
+}
+
+// ------------------------------
+// GpioLineEvent
+// ------------------------------
+GpioLineEvent::GpioLineEvent(const std::string &chip, unsigned line)
+{
+    int chipFd = open(chip.c_str(), O_RDONLY);
+    if (chipFd < 0) {
+        perror("open()");
+        return;
+    }
+
+    gpioevent_request req;
+    std::memset(&req, 0, sizeof(req));
+    req.lineoffset = line;
+    req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    req.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
+    std::strncpy(req.consumer_label, "balance_ball", sizeof(req.consumer_label) - 1);
+
+    if (ioctl(chipFd, GPIO_GET_LINEEVENT_IOCTL, &req) < 0)
+        perror("GPIO_GET_LINEEVENT_IOCTL");
+    else
+        fd_ = req.fd;
+    close(chipFd);
+
+    // consume() drains all queued edges without blocking
+    if (fd_ >= 0)
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+}
+
+int GpioLineEvent::consume()
+{
+    int events = 0;
+    gpioevent_data data;
+    while (read(fd_, &data, sizeof(data)) == sizeof(data))
+        ++events;
+    if (events == 0 && errno != EAGAIN) {
+        perror("read()");
+        return -1;
+    }
+    return events;
+}
+
+// ------------------------------
+// TimerEvent
+// ------------------------------
+TimerEvent::TimerEvent(std::chrono::nanoseconds period)
+{
+    fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (fd_ < 0) {
+        perror("timerfd_create()");
+        return;
+    }
+
+    itimerspec spec;
+    spec.it_interval.tv_sec = period.count() / 1000000000;
+    spec.it_interval.tv_nsec = period.count() % 1000000000;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd_, 0, &spec, nullptr) < 0)
+        perror("timerfd_settime()");
+}
+
+int TimerEvent::consume()
+{
+    uint64_t expirations = 0;
+    if (read(fd_, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        perror("read()");
+        return -1;
+    }
+    return static_cast<int>(expirations);
+}
+
+// ------------------------------
+// ManualEvent
+// ------------------------------
+ManualEvent::ManualEvent()
+{
+    fd_ = eventfd(0, EFD_CLOEXEC);
+    if (fd_ < 0)
+        perror("eventfd()");
+}
+
+void ManualEvent::signal(uint64_t events)
+{
+    if (write(fd_, &events, sizeof(events)) != sizeof(events))
+        perror("write()");
+}
+
+std::unique_ptr<EventSource> ManualEvent::listener() const
+{
+    auto other = std::make_unique<ManualEvent>();
+    close(other->fd_);
+    other->fd_ = fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+    if (other->fd_ < 0)
+        perror("fcntl()");
+    return other;
+}
+
+int ManualEvent::consume()
+{
+    uint64_t events = 0;
+    if (read(fd_, &events, sizeof(events)) != sizeof(events)) {
+        perror("read()");
+        return -1;
+    }
+    return static_cast<int>(events);
+}
@@ -1,6 +1,7 @@
+#include <algorithm>
 #include <thread>
 #include <iostream>
-#include "display.hpp"
+#include <cmath>
 #include "bitmaps.hpp"
 #include "message.hpp"
 #include "broker.hpp"
@@ -10,53 +11,116 @@
 
 static const int ballCenterPosX = 64;
 static const int ballCenterPosY = 16;
+static const int screenWidth = 128;
+static const int screenHeight = 32;
 
-GameControl::GameControl(Display& display) : display(&display) {
-    gameState.ball_x = ballCenterPosX;
-    gameState.ball_y = ballCenterPosY;
-    gameState.score = 0;
-    display.drawDisplay(gameState);
-}
+// Physics, per g of gravity along a board axis
+static const double deadZone = 0.05;      // g, below this the board counts as level
+static const double gain = 400;           // pixels/s^2 per g
+static const double friction = 2;         // 1/s, share of the velocity lost per second
+static const double scoreRate = 1000;     // points/s per g of tilt, while inside
+static const double penaltyRate = 2000;   // points/s, while outside
+static const int maxCatchUpSteps = 5;     // steps run at once after a stall
+
+using Clock = std::chrono::steady_clock;
 
-void GameControl::handleAccelerometer(const std::string& data) {
-    const int speed = 2;
-    double x, y, z;
+static double applyDeadZone(double tilt) {
+    return std::abs(tilt) < deadZone ? 0 : tilt;
+}
 
-    /*
-     * TODO:
-     * Decode the message data
-     * Update gameState ball_x, ball_y according to accl values
-     * Update gameState.score according to accl values
-     * Draw display
-     * Activity 5: publish 'boundary' messsage if ball out of screen
-     */
+GameControl::GameControl(Renderer& renderer, int tickHz)
+    : renderer(&renderer), x(ballCenterPosX), y(ballCenterPosY), prevX(x), prevY(y),
+      step(std::chrono::nanoseconds(1000000000LL / std::max(tickHz, 1))), tick(step) {
+    submit(0, 0);
+    physicsThread = std::thread([this]() { physicsLoop(); });
+}
 
+GameControl::~GameControl() {
+    isActive = false;
+    if (physicsThread.joinable())
+        physicsThread.join();
 }
 
-void GameControl::handleButton(const std::string& data) {
-    int gpio, value;
+void GameControl::onOrientation(const OrientationData& data) {
+    std::lock_guard<std::mutex> lock(state_mtx);
+    tiltX = -std::sin(data.pitch);
+    tiltY = std::sin(data.roll) * std::cos(data.pitch);
+}
 
-    Message::decodeButtonData(data, &gpio, &value);
-    if (value == 0) 
+void GameControl::onButton(const ButtonData& data) {
+    if (data.value == 0)
     {
         std::cout << "RESET" << std::endl;
-        /*
-         * TODO:
-         * Center ball
-         * Reset score
-         */
+
+        std::lock_guard<std::mutex> lock(state_mtx);
+        x = prevX = ballCenterPosX;
+        y = prevY = ballCenterPosY;
+        vx = vy = 0;
+        score = 0;
+        submit(0, 0);
+    }
+}
+
+void GameControl::physicsLoop() {
+    while (isActive) {
+        // Expirations since the last wait, more than one if we were late
+        int ticks = tick.wait(100);
+        if (ticks <= 0)
+            continue;
+
+        bool changed = false;
+        bool nowInside;
+        {
+            std::lock_guard<std::mutex> lock(state_mtx);
+            for (int i = 0; i < std::min(ticks, maxCatchUpSteps); ++i)
+                changed |= stepPhysics();
+            nowInside = inside;
+
+            // Drawn later by the render thread, this only copies
+            auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch());
+            submit(now.count(), step.count());
+        }
+
+        // Published without state_mtx held, subscribers may call back into us
+        if (changed)
+            Broker::getInstance().publish(topics::boundary, BoundaryData{nowInside ? 0 : 1});
     }
 }
 
-/*
-* TODO:
-* Create handler for 'boundary' messages
-* Subtract score by 1000 if the data value is "1"
-*/
+bool GameControl::stepPhysics() {
+    const double dt = std::chrono::duration<double>(step).count();
+    double tx = applyDeadZone(tiltX);
+    double ty = applyDeadZone(tiltY);
 
+    // Tilt left/right accelerates along x, forward/backwards along y
+    // (semi-implicit Euler: the new velocity moves the ball)
+    prevX = x;
+    prevY = y;
+    vx += (-gain * ty - friction * vx) * dt;
+    vy += (-gain * tx - friction * vy) * dt;
+    x += vx * dt;
+    y += vy * dt;
 
-void GameControl::onMessage(const Message& msg){
+    bool wasInside = inside;
+    inside = x >= 0 && x <= screenWidth - ballWidth && y >= 0 && y <= screenHeight - ballHeight;
 
-    if (msg.topic.compare("btn") == 0)
-        handleButton(msg.data);
-}
\ No newline at end of file
+    // The more tilt, the faster the score grows; outside it drains
+    if (inside)
+        score += (std::abs(tx) + std::abs(ty)) * scoreRate * dt;
+    else
+        score -= penaltyRate * dt;
+
+    return inside != wasInside;
+}
+
+void GameControl::submit(int64_t stepTimeNs, int64_t stepNs) {
+    GameFrame frame;
+    frame.prevX = float(prevX);
+    frame.prevY = float(prevY);
+    frame.x = float(x);
+    frame.y = float(y);
+    frame.score = int(std::lround(score));
+    frame.stepTimeNs = stepTimeNs;
+    frame.stepNs = stepNs;
+    renderer->submit(frame);
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <algorithm>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "input_thread.hpp"
+
+InputThread::InputThread()
+{
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1()");
+        return;
+    }
+
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd < 0) {
+        perror("eventfd()");
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, wakeFd, &ev) < 0)
+        perror("epoll_ctl()");
+}
+
+InputThread::~InputThread()
+{
+    stop();
+    if (wakeFd >= 0)
+        close(wakeFd);
+    if (epfd >= 0)
+        close(epfd);
+}
+
+bool InputThread::add(std::unique_ptr<Button> &button)
+{
+    if (epfd < 0 || !button || !button->isOpen())
+        return false;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = button.get();
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, button->getFd(), &ev) < 0) {
+        perror("epoll_ctl()"); // EPERM: the driver does not support poll
+        return false;
+    }
+    buttons.push_back(std::move(button));
+    return true;
+}
+
+void InputThread::stop()
+{
+    isActive = false;
+    uint64_t one = 1;
+    if (wakeFd >= 0 && write(wakeFd, &one, sizeof(one)) != sizeof(one))
+        perror("write()");
+}
+
+void InputThread::run()
+{
+    if (epfd < 0)
+        return;
+
+    epoll_event events[16];
+
+    while (isActive)
+    {
+        // Sleep until an edge or the end of the earliest debounce window
+        auto now = Button::Clock::now();
+        auto deadline = Button::Clock::time_point::max();
+        for (auto &button : buttons)
+            deadline = std::min(deadline, button->deadline());
+
+        int timeoutMs = -1;
+        if (deadline != Button::Clock::time_point::max()) {
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+            timeoutMs = static_cast<int>(std::max<int64_t>(0, wait.count()));
+        }
+
+        int ready = epoll_wait(epfd, events, 16, timeoutMs);
+        if (ready < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait()");
+            break;
+        }
+
+        // One timestamp per wakeup, all edges in it happened by then
+        now = Button::Clock::now();
+        for (int i = 0; i < ready; ++i) {
+            auto *button = static_cast<Button *>(events[i].data.ptr);
+            if (!button) {
+                uint64_t count;
+                if (read(wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+                    perror("read()");
+                continue;
+            }
+            if (button->readInput(now) < 0)
+                epoll_ctl(epfd, EPOLL_CTL_DEL, button->getFd(), nullptr);
+        }
+
+        for (auto &button : buttons)
+            button->settle(now);
+    }
+}
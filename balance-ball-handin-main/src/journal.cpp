@@ -0,0 +1,219 @@
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "broker.hpp"
+#include "journal.hpp"
+
+static constexpr std::size_t topicEntrySize(std::size_t nameLength)
+{
+    return 1 + sizeof(TopicId) + 1 + nameLength;
+}
+
+static constexpr std::size_t messageEntrySize = 1 + sizeof(TopicId) + sizeof(int64_t) + sizeof(Payload);
+
+// ---------------------------
+// JournalWriter
+// ---------------------------
+JournalWriter::JournalWriter(const std::string &path, std::size_t capacity) : capacity(capacity)
+{
+    fd = open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("open()");
+        return;
+    }
+
+    // Sparse, zero filled file: unused space reads as End entries
+    if (ftruncate(fd, capacity) < 0) {
+        perror("ftruncate()");
+        return;
+    }
+
+    void *mapped = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        perror("mmap()");
+        return;
+    }
+    base = static_cast<uint8_t *>(mapped);
+
+    JournalHeader header{JournalHeader::magicValue, sizeof(Payload)};
+    std::memcpy(base, &header, sizeof(header));
+    used = sizeof(header);
+}
+
+JournalWriter::~JournalWriter()
+{
+    if (base) {
+        std::size_t length = std::min(used.load(), capacity);
+        msync(base, length, MS_SYNC);
+        munmap(base, capacity);
+        // Cut the preallocated tail, keep one End byte if there is room
+        if (ftruncate(fd, std::min(length + 1, capacity)) < 0)
+            perror("ftruncate()");
+    }
+    if (fd >= 0)
+        close(fd);
+}
+
+uint8_t *JournalWriter::reserve(std::size_t size)
+{
+    std::size_t offset = used.fetch_add(size, std::memory_order_relaxed);
+    if (offset + size > capacity)
+        return nullptr;
+    return base + offset;
+}
+
+void JournalWriter::writeTopic(TopicId topic)
+{
+    std::lock_guard<std::mutex> lock(topicMtx);
+    if (namedTopics[topic].load())
+        return;
+
+    std::string_view name = Broker::getInstance().topicName(topic);
+    std::size_t length = std::min<std::size_t>(name.size(), 255);
+    uint8_t *entry = reserve(topicEntrySize(length));
+    if (!entry)
+        return;
+
+    entry[1] = topic & 0xFF;
+    entry[2] = topic >> 8;
+    entry[3] = static_cast<uint8_t>(length);
+    std::memcpy(entry + 4, name.data(), length);
+    std::atomic_ref<uint8_t>(entry[0]).store(static_cast<uint8_t>(JournalEntry::Topic), std::memory_order_release);
+
+    // Set after the entry is reserved, so it precedes the topic's messages
+    namedTopics[topic].store(true);
+}
+
+void JournalWriter::onMessage(const Message &msg)
+{
+    if (!base)
+        return;
+
+    if (!namedTopics[msg.topic].load(std::memory_order_acquire))
+        writeTopic(msg.topic);
+
+    uint8_t *entry = reserve(messageEntrySize);
+    if (!entry) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    int64_t timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(msg.timestamp.time_since_epoch()).count();
+    std::memcpy(entry + 1, &msg.topic, sizeof(TopicId));
+    std::memcpy(entry + 1 + sizeof(TopicId), &timestampNs, sizeof(timestampNs));
+    std::memcpy(entry + 1 + sizeof(TopicId) + sizeof(timestampNs), &msg.payload, sizeof(Payload));
+    std::atomic_ref<uint8_t>(entry[0]).store(static_cast<uint8_t>(JournalEntry::Message), std::memory_order_release);
+
+    recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ---------------------------
+// JournalReplayer
+// ---------------------------
+JournalReplayer::JournalReplayer(const std::string &path)
+{
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        perror("open()");
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(JournalHeader))) {
+        std::cerr << "[JournalReplayer] " << path << " is too short\n";
+        return;
+    }
+
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        perror("mmap()");
+        return;
+    }
+
+    JournalHeader header;
+    std::memcpy(&header, mapped, sizeof(header));
+    if (header.magic != JournalHeader::magicValue || header.payloadSize != sizeof(Payload)) {
+        std::cerr << "[JournalReplayer] " << path << " is not a journal of this build\n";
+        munmap(mapped, st.st_size);
+        return;
+    }
+
+    base = static_cast<const uint8_t *>(mapped);
+    size = st.st_size;
+}
+
+JournalReplayer::~JournalReplayer()
+{
+    if (base)
+        munmap(const_cast<uint8_t *>(base), size);
+    if (fd >= 0)
+        close(fd);
+}
+
+uint64_t JournalReplayer::replay(double speed)
+{
+    if (!base)
+        return 0;
+
+    std::vector<TopicId> localIds; // recorded topic id -> id in this process
+    uint64_t count = 0;
+    bool first = true;
+    int64_t firstNs = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    std::size_t offset = sizeof(JournalHeader);
+    while (offset < size)
+    {
+        auto type = static_cast<JournalEntry>(base[offset]);
+
+        if (type == JournalEntry::Topic) {
+            if (offset + topicEntrySize(0) > size)
+                break;
+            TopicId id = base[offset + 1] | (base[offset + 2] << 8);
+            std::size_t length = base[offset + 3];
+            if (offset + topicEntrySize(length) > size)
+                break;
+            std::string_view name(reinterpret_cast<const char *>(base + offset + 4), length);
+            if (id >= localIds.size())
+                localIds.resize(id + 1, Broker::invalidTopic);
+            localIds[id] = Broker::getInstance().registerTopic(name);
+            offset += topicEntrySize(length);
+        }
+        else if (type == JournalEntry::Message) {
+            if (offset + messageEntrySize > size)
+                break;
+            TopicId id;
+            int64_t timestampNs;
+            Payload payload;
+            std::memcpy(&id, base + offset + 1, sizeof(id));
+            std::memcpy(&timestampNs, base + offset + 1 + sizeof(id), sizeof(timestampNs));
+            std::memcpy(&payload, base + offset + 1 + sizeof(id) + sizeof(timestampNs), sizeof(Payload));
+            offset += messageEntrySize;
+
+            if (first) {
+                firstNs = timestampNs;
+                first = false;
+            }
+            if (speed > 0) {
+                auto due = std::chrono::nanoseconds(static_cast<int64_t>((timestampNs - firstNs) / speed));
+                std::this_thread::sleep_until(start + due);
+            }
+
+            TopicId local = id < localIds.size() ? localIds[id] : Broker::invalidTopic;
+            Broker::getInstance().publish(makeMessage(local, payload));
+            ++count;
+        }
+        else {
+            break; // End
+        }
+    }
+
+    return count;
+}
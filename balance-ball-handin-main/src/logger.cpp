@@ -1,8 +1,9 @@
 #include <iostream>
 #include "logger.hpp"
+#include "broker.hpp"
 
 
 void Logger::onMessage(const Message &msg)
 {
-    std::cout << "[" << msg.topic << "] " << msg.data << std::endl;
-}
\ No newline at end of file
+    std::cout << "[" << Broker::getInstance().topicName(msg.topic) << "] " << msg.toString() << std::endl;
+}
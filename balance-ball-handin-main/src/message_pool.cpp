@@ -0,0 +1,150 @@
+#include <new>
+#include "message_pool.hpp"
+
+// ---------------------------
+// Per-thread cache
+// ---------------------------
+namespace {
+
+struct ThreadCache {
+    MessagePool::Slot *head = nullptr;
+    std::size_t count = 0;
+
+    MessagePool::Slot *pop() {
+        if (!head) {
+            MessagePool::Slot *batch[MessagePool::cacheBatch];
+            std::size_t n = MessagePool::getInstance().take(batch, MessagePool::cacheBatch);
+            for (std::size_t i = 0; i < n; ++i)
+                push(batch[i]);
+        }
+        MessagePool::Slot *slot = head;
+        head = slot->next;
+        --count;
+        return slot;
+    }
+
+    void push(MessagePool::Slot *slot) {
+        slot->next = head;
+        head = slot;
+        ++count;
+    }
+
+    // Hand a batch back when this thread frees more than it allocates
+    // (e.g. a delivery thread releasing messages published elsewhere)
+    void trim(std::size_t keep) {
+        if (count <= keep)
+            return;
+        MessagePool::Slot *first = head;
+        MessagePool::Slot *last = head;
+        for (std::size_t i = 1; i < count - keep; ++i)
+            last = last->next;
+        head = last->next;
+        count = keep;
+        MessagePool::getInstance().give(first, last);
+    }
+
+    ~ThreadCache() { trim(0); }
+};
+
+thread_local ThreadCache cache;
+
+MessagePool::Slot *slotOf(const Message *msg) {
+    return reinterpret_cast<MessagePool::Slot *>(const_cast<Message *>(msg));
+}
+
+} // namespace
+
+// ---------------------------
+// Handles
+// ---------------------------
+void MessageDeleter::operator()(Message *msg) const {
+    MessagePool::getInstance().release(msg);
+}
+
+MessageRef::MessageRef(const MessageRef &other) : msg(other.msg) {
+    if (msg)
+        MessagePool::getInstance().retain(msg);
+}
+
+void MessageRef::reset() {
+    if (msg)
+        MessagePool::getInstance().release(msg);
+    msg = nullptr;
+}
+
+// ---------------------------
+// MessagePool
+// ---------------------------
+void MessagePool::addSlab() {
+    slabs.emplace_back(new Slot[slabSize]);
+    Slot *slab = slabs.back().get();
+    for (std::size_t i = 0; i < slabSize; ++i) {
+        slab[i].next = freeList;
+        freeList = &slab[i];
+    }
+}
+
+void MessagePool::reserve(std::size_t messages) {
+    std::lock_guard<std::mutex> lock(mtx);
+    while (slabs.size() * slabSize < messages)
+        addSlab();
+}
+
+std::size_t MessagePool::take(Slot **out, std::size_t n) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!freeList)
+        addSlab();
+
+    std::size_t taken = 0;
+    while (taken < n && freeList) {
+        out[taken++] = freeList;
+        freeList = freeList->next;
+    }
+    return taken;
+}
+
+void MessagePool::give(Slot *head, Slot *tail) {
+    std::lock_guard<std::mutex> lock(mtx);
+    tail->next = freeList;
+    freeList = head;
+}
+
+MessagePtr MessagePool::make(TopicId topic, const Payload &payload) {
+    Slot *slot = cache.pop();
+    slot->refs.store(1, std::memory_order_relaxed);
+    Message *msg = new (slot->storage) Message(topic, payload);
+
+    std::size_t used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::size_t high = highWaterMark.load(std::memory_order_relaxed);
+    while (used > high && !highWaterMark.compare_exchange_weak(high, used, std::memory_order_relaxed))
+        ;
+
+    return MessagePtr(msg);
+}
+
+void MessagePool::retain(const Message *msg) {
+    slotOf(msg)->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MessagePool::release(const Message *msg) {
+    Slot *slot = slotOf(msg);
+    if (slot->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    msg->~Message();
+    inUse.fetch_sub(1, std::memory_order_relaxed);
+    cache.push(slot);
+    cache.trim(2 * cacheBatch);
+}
+
+PoolStats MessagePool::stats() {
+    PoolStats s;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        s.slabs = slabs.size();
+    }
+    s.capacity = s.slabs * slabSize;
+    s.inUse = inUse.load(std::memory_order_relaxed);
+    s.highWaterMark = highWaterMark.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cmath>
+#include "orientation_filter.hpp"
+
+static constexpr float pi = 3.14159265358979f;
+static constexpr float degToRad = pi / 180.0f;
+static constexpr float gravityBand = 0.3f; // g away from 1 g where the accelerometer is ignored
+
+ComplementaryFilter::ComplementaryFilter(float sampleRateHz, float tau) : tau(tau)
+{
+    setSampleRate(sampleRateHz);
+}
+
+void ComplementaryFilter::setSampleRate(float hz)
+{
+    dt = 1.0f / std::max(hz, 1.0f);
+    gain = dt / (tau + dt);
+}
+
+OrientationData ComplementaryFilter::fromGravity(const float accel[3])
+{
+    // Gravity in sensor axes is (-sin p, sin r cos p, cos r cos p)
+    float roll = std::atan2(accel[1], accel[2]);
+    float pitch = std::atan2(-accel[0], std::sqrt(accel[1] * accel[1] + accel[2] * accel[2]));
+    return {roll, pitch};
+}
+
+OrientationData ComplementaryFilter::update(const float accel[3], const float gyro[3])
+{
+    OrientationData measured = fromGravity(accel);
+    if (!initialized) {
+        roll = measured.roll;
+        pitch = measured.pitch;
+        initialized = true;
+        return {roll, pitch};
+    }
+
+    // Body rates to Euler angle rates (roll about x, then pitch about y)
+    float wx = gyro[0] * degToRad, wy = gyro[1] * degToRad, wz = gyro[2] * degToRad;
+    float sr = std::sin(roll), cr = std::cos(roll);
+    float cp = std::max(std::cos(pitch), 0.05f); // roll is undefined at +-90 degrees pitch
+    float tp = std::sin(pitch) / cp;
+    roll += (wx + (sr * wy + cr * wz) * tp) * dt;
+    pitch += (cr * wy - sr * wz) * dt;
+
+    float norm = std::sqrt(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+    float trust = std::clamp(1.0f - std::abs(norm - 1.0f) / gravityBand, 0.0f, 1.0f);
+    float k = gain * trust;
+
+    // Correct along the shorter way round, roll wraps at +-pi
+    float rollError = std::remainder(measured.roll - roll, 2 * pi);
+    roll = std::remainder(roll + k * rollError, 2 * pi);
+    pitch += k * (measured.pitch - pitch);
+
+    return {roll, pitch};
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <ostream>
+#include "renderer.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+Renderer::Renderer(Display &display, int maxFps) : display(display)
+{
+    setMaxFps(maxFps);
+    thread = std::thread([this]() { renderThread(); });
+}
+
+Renderer::~Renderer()
+{
+    isActive = false;
+    sequence.fetch_add(1, std::memory_order_release);
+    sequence.notify_one();
+    if (thread.joinable())
+        thread.join();
+}
+
+void Renderer::setMaxFps(int maxFps)
+{
+    periodNs = 1000000000LL / std::max(maxFps, 1);
+}
+
+void Renderer::submit(const GameFrame &frame)
+{
+    frames.write(frame);
+    submitted.fetch_add(1, std::memory_order_relaxed);
+    sequence.fetch_add(1, std::memory_order_release);
+    sequence.notify_one();
+}
+
+RendererStats Renderer::stats() const
+{
+    RendererStats s;
+    s.submitted = submitted.load(std::memory_order_relaxed);
+    s.rendered = rendered.load(std::memory_order_relaxed);
+    s.skipped = s.submitted > s.rendered ? s.submitted - s.rendered : 0;
+    return s;
+}
+
+void Renderer::renderThread()
+{
+    uint32_t seen = sequence.load(std::memory_order_acquire);
+    auto nextFrame = Clock::now();
+    GameFrame frame{};
+
+    while (isActive)
+    {
+        // Sleep until there is a new frame, then until the frame slot
+        sequence.wait(seen, std::memory_order_acquire);
+        std::this_thread::sleep_until(nextFrame);
+        seen = sequence.load(std::memory_order_acquire);
+
+        if (!frames.read(frame))
+            continue;
+
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch());
+        display.drawDisplay(frame.at(now.count()));
+        rendered.fetch_add(1, std::memory_order_relaxed);
+
+        // A late frame does not make the next ones come faster
+        auto period = std::chrono::nanoseconds(periodNs.load(std::memory_order_relaxed));
+        nextFrame = std::max(nextFrame + period, Clock::now());
+    }
+}
+
+void RendererStats::print(std::ostream &out) const
+{
+    out << "[Renderer] submitted " << submitted << ", rendered " << rendered << ", skipped " << skipped << "\n";
+}
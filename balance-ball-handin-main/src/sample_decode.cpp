@@ -0,0 +1,160 @@
+#include "sample_decode.hpp"
+
+// The vector paths load the int16 values as they are in memory
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DECODE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DECODE_SSE2
+#endif
+#endif
+
+static constexpr std::size_t tripleBytes = 6;
+
+static inline int16_t le16(const uint8_t *p)
+{
+    return static_cast<int16_t>(p[1] << 8 | p[0]);
+}
+
+// ------------------------------
+// Scalar (reference)
+// ------------------------------
+static void decodeTail(const uint8_t *src, std::size_t first, std::size_t frames, int sensors,
+                       const float *scales, const Vec3Array *out)
+{
+    for (std::size_t f = first; f < frames; ++f) {
+        const uint8_t *frame = src + f * sensors * tripleBytes;
+        for (int s = 0; s < sensors; ++s) {
+            const uint8_t *p = frame + s * tripleBytes;
+            out[s].x[f] = le16(p) * scales[s];
+            out[s].y[f] = le16(p + 2) * scales[s];
+            out[s].z[f] = le16(p + 4) * scales[s];
+        }
+    }
+}
+
+void decodeFramesScalar(const uint8_t *src, std::size_t frames, int sensors, const float *scales,
+                        const Vec3Array *out)
+{
+    decodeTail(src, 0, frames, sensors, scales, out);
+}
+
+// ------------------------------
+// NEON, 8 frames per step
+// ------------------------------
+#if defined(DECODE_NEON)
+static inline void store8(int16x8_t v, float scale, float *dst)
+{
+    vst1q_f32(dst, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+    vst1q_f32(dst + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+}
+
+void decodeFrames(const uint8_t *src, std::size_t frames, int sensors, const float *scales, const Vec3Array *out)
+{
+    std::size_t f = 0;
+    if (sensors == 1) {
+        // vld3 splits the triples into x, y and z lanes
+        for (; f + 8 <= frames; f += 8) {
+            int16x8x3_t v = vld3q_s16(reinterpret_cast<const int16_t *>(src + f * tripleBytes));
+            store8(v.val[0], scales[0], out[0].x + f);
+            store8(v.val[1], scales[0], out[0].y + f);
+            store8(v.val[2], scales[0], out[0].z + f);
+        }
+    }
+    else if (sensors == 2) {
+        // Lanes alternate between the sensors, uzp separates them
+        for (; f + 8 <= frames; f += 8) {
+            auto p = reinterpret_cast<const int16_t *>(src + f * 2 * tripleBytes);
+            int16x8x3_t a = vld3q_s16(p);
+            int16x8x3_t b = vld3q_s16(p + 24);
+            int16x8x2_t x = vuzpq_s16(a.val[0], b.val[0]);
+            int16x8x2_t y = vuzpq_s16(a.val[1], b.val[1]);
+            int16x8x2_t z = vuzpq_s16(a.val[2], b.val[2]);
+            for (int s = 0; s < 2; ++s) {
+                store8(x.val[s], scales[s], out[s].x + f);
+                store8(y.val[s], scales[s], out[s].y + f);
+                store8(z.val[s], scales[s], out[s].z + f);
+            }
+        }
+    }
+    decodeTail(src, f, frames, sensors, scales, out);
+}
+
+const char *decodeKernelName() { return "neon"; }
+
+// ------------------------------
+// SSE2, 4 frames per step
+// ------------------------------
+#elif defined(DECODE_SSE2)
+// Four int16 at p as floats
+static inline __m128 load4(const uint8_t *p)
+{
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+// Four consecutive triples (24 bytes) into x, y and z vectors
+static inline void transpose4(const uint8_t *p, __m128 &x, __m128 &y, __m128 &z)
+{
+    __m128 f0 = load4(p);      // x0 y0 z0 x1
+    __m128 f1 = load4(p + 8);  // y1 z1 x2 y2
+    __m128 f2 = load4(p + 16); // z2 x3 y3 z3
+    x = _mm_shuffle_ps(_mm_shuffle_ps(f0, f0, _MM_SHUFFLE(3, 3, 0, 0)),
+                       _mm_shuffle_ps(f1, f2, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(0, 0, 1, 1)),
+                       _mm_shuffle_ps(f1, f2, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(1, 1, 2, 2)),
+                       _mm_shuffle_ps(f2, f2, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+void decodeFrames(const uint8_t *src, std::size_t frames, int sensors, const float *scales, const Vec3Array *out)
+{
+    std::size_t f = 0;
+    if (sensors == 1) {
+        __m128 scale = _mm_set1_ps(scales[0]);
+        for (; f + 4 <= frames; f += 4) {
+            __m128 x, y, z;
+            transpose4(src + f * tripleBytes, x, y, z);
+            _mm_storeu_ps(out[0].x + f, _mm_mul_ps(x, scale));
+            _mm_storeu_ps(out[0].y + f, _mm_mul_ps(y, scale));
+            _mm_storeu_ps(out[0].z + f, _mm_mul_ps(z, scale));
+        }
+    }
+    else if (sensors == 2) {
+        // Eight triples alternating between the sensors, even lanes are
+        // the first sensor, odd lanes the second
+        __m128 scale0 = _mm_set1_ps(scales[0]);
+        __m128 scale1 = _mm_set1_ps(scales[1]);
+        for (; f + 4 <= frames; f += 4) {
+            __m128 x01, y01, z01, x23, y23, z23;
+            transpose4(src + f * 2 * tripleBytes, x01, y01, z01);
+            transpose4(src + f * 2 * tripleBytes + 24, x23, y23, z23);
+
+            auto even = [](__m128 a, __m128 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)); };
+            auto odd = [](__m128 a, __m128 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)); };
+            _mm_storeu_ps(out[0].x + f, _mm_mul_ps(even(x01, x23), scale0));
+            _mm_storeu_ps(out[0].y + f, _mm_mul_ps(even(y01, y23), scale0));
+            _mm_storeu_ps(out[0].z + f, _mm_mul_ps(even(z01, z23), scale0));
+            _mm_storeu_ps(out[1].x + f, _mm_mul_ps(odd(x01, x23), scale1));
+            _mm_storeu_ps(out[1].y + f, _mm_mul_ps(odd(y01, y23), scale1));
+            _mm_storeu_ps(out[1].z + f, _mm_mul_ps(odd(z01, z23), scale1));
+        }
+    }
+    decodeTail(src, f, frames, sensors, scales, out);
+}
+
+const char *decodeKernelName() { return "sse2"; }
+
+// ------------------------------
+// No vector unit
+// ------------------------------
+#else
+void decodeFrames(const uint8_t *src, std::size_t frames, int sensors, const float *scales, const Vec3Array *out)
+{
+    decodeTail(src, 0, frames, sensors, scales, out);
+}
+
+const char *decodeKernelName() { return "scalar"; }
+#endif
@@ -0,0 +1,270 @@
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "broker.hpp"
+#include "shm_transport.hpp"
+
+static int64_t toNs(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+// ---------------------------
+// ShmPublisher
+// ---------------------------
+ShmPublisher::ShmPublisher(std::string name, uint32_t capacity) : name(std::move(name))
+{
+    // A segment left by a crashed run may still be mapped by readers. Clear
+    // its magic so they let go of it, and start over in a new segment rather
+    // than re-initializing one that is being read.
+    int old = shm_open(this->name.c_str(), O_RDWR, 0);
+    if (old >= 0) {
+        uint32_t cleared = 0;
+        if (pwrite(old, &cleared, sizeof(cleared), 0) < 0)
+            perror("pwrite()");
+        close(old);
+        shm_unlink(this->name.c_str());
+    }
+
+    fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("shm_open()");
+        return;
+    }
+
+    mappedSize = sizeof(ShmHeader) + capacity * sizeof(ShmRecord);
+    if (ftruncate(fd, mappedSize) < 0) {
+        perror("ftruncate()");
+        return;
+    }
+
+    void *base = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        perror("mmap()");
+        return;
+    }
+
+    header = new (base) ShmHeader;
+    header->capacity = capacity;
+    header->head.store(0);
+    header->topicCount.store(0);
+    records = reinterpret_cast<ShmRecord *>(static_cast<char *>(base) + sizeof(ShmHeader));
+    for (uint32_t i = 0; i < capacity; ++i)
+        new (&records[i]) ShmRecord{};
+
+    // Readers check the magic first, so it is set after the layout is
+    // initialized
+    header->magic.store(ShmHeader::magicValue, std::memory_order_release);
+}
+
+ShmPublisher::~ShmPublisher()
+{
+    if (header) {
+        // Tells attached readers that this run is over
+        header->magic.store(0, std::memory_order_release);
+        munmap(header, mappedSize);
+    }
+    if (fd >= 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+    }
+}
+
+void ShmPublisher::onMessage(const Message &msg)
+{
+    if (!header || msg.topic >= ShmHeader::maxTopics)
+        return;
+
+    // Export the topic name the first time the topic is seen
+    if (msg.topic >= namedTopics.size())
+        namedTopics.resize(msg.topic + 1, false);
+    if (!namedTopics[msg.topic]) {
+        std::string_view topicName = Broker::getInstance().topicName(msg.topic);
+        char *dst = header->topicNames[msg.topic];
+        std::size_t n = std::min(topicName.size(), std::size_t(ShmHeader::maxNameLength - 1));
+        std::memcpy(dst, topicName.data(), n);
+        dst[n] = '\0';
+        namedTopics[msg.topic] = true;
+        if (header->topicCount.load() <= msg.topic)
+            header->topicCount.store(msg.topic + 1, std::memory_order_release);
+    }
+
+    // Single writer (one Async delivery thread): head is only read by the readers
+    uint64_t n = header->head.load(std::memory_order_relaxed);
+    ShmRecord &rec = records[n % header->capacity];
+
+    rec.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    rec.topic = msg.topic;
+    rec.timestampNs = toNs(msg.timestamp);
+    rec.payload = msg.payload;
+    rec.seq.store(2 * n + 2, std::memory_order_release);
+
+    header->head.store(n + 1, std::memory_order_release);
+}
+
+// ---------------------------
+// ShmSubscriber
+// ---------------------------
+ShmSubscriber::ShmSubscriber(const std::string &name) : name(name)
+{
+    // Start with new records only
+    if (attach(false))
+        cursor = header->head.load(std::memory_order_acquire);
+}
+
+ShmSubscriber::~ShmSubscriber()
+{
+    detach();
+}
+
+// quiet: no writer running is expected, don't report it
+bool ShmSubscriber::attach(bool quiet)
+{
+    // Mapped read/write only because 64-bit atomic loads on 32-bit ARM need
+    // a writable mapping; the reader never stores to the segment.
+    fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        if (!quiet)
+            perror("shm_open()");
+        return false;
+    }
+
+    // magic and capacity lead the header
+    uint32_t probe[2] = {0, 0};
+    if (pread(fd, probe, sizeof(probe), 0) != sizeof(probe) || probe[0] != ShmHeader::magicValue) {
+        if (!quiet)
+            std::cerr << "[ShmSubscriber] " << name << " is not a broker segment\n";
+        detach();
+        return false;
+    }
+
+    mappedSize = sizeof(ShmHeader) + probe[1] * sizeof(ShmRecord);
+    void *base = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        perror("mmap()");
+        detach();
+        return false;
+    }
+
+    header = static_cast<ShmHeader *>(base);
+    records = reinterpret_cast<ShmRecord *>(static_cast<char *>(base) + sizeof(ShmHeader));
+
+    // Pairs with the writer's store, the layout is initialized from here on
+    if (header->magic.load(std::memory_order_acquire) != ShmHeader::magicValue) {
+        detach();
+        return false;
+    }
+    return true;
+}
+
+void ShmSubscriber::detach()
+{
+    if (header)
+        munmap(header, mappedSize);
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    header = nullptr;
+    records = nullptr;
+}
+
+// A new run of the writer numbers its records and topics afresh
+void ShmSubscriber::restart()
+{
+    cursor = 0;
+    wanted.assign(wanted.size(), -1);
+}
+
+void ShmSubscriber::subscribe(std::string_view pattern)
+{
+    if (!TopicTrie<bool>::valid(pattern)) {
+        std::cerr << "[ShmSubscriber] Invalid topic pattern: " << pattern << "\n";
+        return;
+    }
+    patterns.insert(pattern, true);
+    wanted.assign(wanted.size(), -1);
+}
+
+bool ShmSubscriber::resolve(TopicId remote)
+{
+    if (remote >= wanted.size()) {
+        wanted.resize(remote + 1, -1);
+        localIds.resize(remote + 1, Broker::invalidTopic);
+    }
+    if (wanted[remote] >= 0)
+        return wanted[remote] == 1;
+
+    // Name not exported yet, try again with the next record
+    if (remote >= header->topicCount.load(std::memory_order_acquire))
+        return false;
+
+    const char *name = header->topicNames[remote];
+    std::vector<bool> matches;
+    patterns.match(name, matches);
+    wanted[remote] = matches.empty() ? 0 : 1;
+    if (wanted[remote])
+        localIds[remote] = Broker::getInstance().registerTopic(name);
+    return wanted[remote] == 1;
+}
+
+std::size_t ShmSubscriber::pump()
+{
+    // The writer exited, or its next run replaced the segment
+    if (header && header->magic.load(std::memory_order_acquire) != ShmHeader::magicValue)
+        detach();
+    if (!header) {
+        if (!attach(true))
+            return 0;
+        restart();
+    }
+
+    std::size_t delivered = 0;
+    uint64_t head = header->head.load(std::memory_order_acquire);
+
+    // head only moves back if the segment was re-initialized in place; read
+    // it from the start rather than let head - cursor wrap
+    if (head < cursor)
+        restart();
+
+    // Lapped by the writer, skip what has been overwritten already
+    if (head - cursor > header->capacity) {
+        lost += head - cursor - header->capacity;
+        cursor = head - header->capacity;
+    }
+
+    for (; cursor < head; ++cursor)
+    {
+        const ShmRecord &rec = records[cursor % header->capacity];
+        uint64_t expected = 2 * cursor + 2;
+        if (rec.seq.load(std::memory_order_acquire) != expected) {
+            ++lost;
+            continue;
+        }
+
+        TopicId topic = rec.topic;
+        int64_t timestampNs = rec.timestampNs;
+        Payload payload = rec.payload;
+
+        // Overwritten while we copied it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (rec.seq.load(std::memory_order_relaxed) != expected) {
+            ++lost;
+            continue;
+        }
+
+        if (!resolve(topic))
+            continue;
+
+        MessagePtr msg = makeMessage(localIds[topic], payload);
+        msg->timestamp = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(timestampNs));
+        Broker::getInstance().publish(std::move(msg));
+        ++delivered;
+    }
+
+    return delivered;
+}
@@ -0,0 +1,409 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include "sim_bmi160.hpp"
+
+// Registers (datasheet section 2.11)
+namespace {
+constexpr uint8_t CHIP_ID = 0x00;
+constexpr uint8_t PMU_STATUS = 0x03;
+constexpr uint8_t GYR_DATA = 0x0C;
+constexpr uint8_t ACC_DATA = 0x12;
+constexpr uint8_t SENSORTIME = 0x18;
+constexpr uint8_t STATUS = 0x1B;
+constexpr uint8_t INT_STATUS_1 = 0x1D;
+constexpr uint8_t FIFO_LENGTH_0 = 0x22;
+constexpr uint8_t FIFO_LENGTH_1 = 0x23;
+constexpr uint8_t FIFO_DATA = 0x24;
+constexpr uint8_t ACC_CONF = 0x40;
+constexpr uint8_t ACC_RANGE = 0x41;
+constexpr uint8_t GYR_CONF = 0x42;
+constexpr uint8_t GYR_RANGE = 0x43;
+constexpr uint8_t FIFO_CONFIG_0 = 0x46;
+constexpr uint8_t FIFO_CONFIG_1 = 0x47;
+constexpr uint8_t INT_EN_1 = 0x51;
+constexpr uint8_t INT_OUT_CTRL = 0x53;
+constexpr uint8_t INT_MAP_1 = 0x56;
+constexpr uint8_t CMD = 0x7E;
+
+constexpr uint8_t DRDY_ACC = 0x80;
+constexpr uint8_t DRDY_GYR = 0x40;
+constexpr uint8_t FIFO_GYR_EN = 0x80;
+constexpr uint8_t FIFO_ACC_EN = 0x40;
+constexpr uint8_t FIFO_HEADER_EN = 0x10;
+
+// Output data rate of an ACC_CONF/GYR_CONF code, 100 Hz at code 8
+double rateOf(uint8_t conf)
+{
+    int code = conf & 0x0F;
+    return code == 0 ? 0 : 100.0 * std::pow(2.0, code - 8);
+}
+
+void store16(uint8_t *dst, double value)
+{
+    auto v = static_cast<int16_t>(std::clamp(std::lround(value), -32768L, 32767L));
+    dst[0] = static_cast<uint8_t>(v & 0xFF);
+    dst[1] = static_cast<uint8_t>((v >> 8) & 0xFF);
+}
+} // namespace
+
+SimBMI160::SimBMI160(BusTiming timing, double timeScale)
+    : timing(timing), timeScale(timeScale), epoch(std::chrono::steady_clock::now())
+{
+    reset();
+}
+
+SimBMI160::~SimBMI160()
+{
+    ticking = false;
+    if (ticker.joinable())
+        ticker.join();
+}
+
+void SimBMI160::reset()
+{
+    regs.fill(0);
+    regs[CHIP_ID] = chipId;
+    regs[ACC_CONF] = 0x28;
+    regs[ACC_RANGE] = 0x03;
+    regs[GYR_CONF] = 0x28;
+    regs[GYR_RANGE] = 0x00;
+    regs[FIFO_CONFIG_0] = 0x80;
+    regs[FIFO_CONFIG_1] = FIFO_HEADER_EN;
+    fifoHead = fifoFill = 0;
+    accelOn = gyroOn = false;
+    int1Level = false;
+}
+
+double SimBMI160::now() const
+{
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - epoch;
+    return elapsed.count() * timeScale;
+}
+
+double SimBMI160::odrHz() const
+{
+    double hz = 0;
+    if (accelOn)
+        hz = std::max(hz, rateOf(regs[ACC_CONF]));
+    if (gyroOn)
+        hz = std::max(hz, rateOf(regs[GYR_CONF]));
+    return hz;
+}
+
+// ------------------------------
+// Sample generation
+// ------------------------------
+void SimBMI160::advance()
+{
+    double t = now();
+    double hz = odrHz();
+    if (hz == 0) {
+        nextSample = t;
+        return;
+    }
+
+    // After a long pause only the last FIFO's worth is observable
+    double backlog = (t - nextSample) * hz;
+    if (backlog > 256) {
+        auto skipped = static_cast<uint64_t>(backlog - 256);
+        counters.samplesGenerated += skipped;
+        if (regs[FIFO_CONFIG_1] & (FIFO_GYR_EN | FIFO_ACC_EN))
+            counters.fifoOverflows += skipped;
+        nextSample += skipped / hz;
+    }
+
+    while (nextSample <= t) {
+        sample(nextSample);
+        nextSample += 1.0 / hz;
+    }
+}
+
+void SimBMI160::sample(double t)
+{
+    Motion m = script ? script(t) : Motion{};
+    if (accelNoise > 0) {
+        std::normal_distribution<double> noise(0, accelNoise);
+        for (double &a : m.accel)
+            a += noise(rng);
+    }
+    if (gyroNoise > 0) {
+        std::normal_distribution<double> noise(0, gyroNoise);
+        for (double &g : m.gyro)
+            g += noise(rng);
+    }
+
+    double accelLsb = 16384;
+    switch (regs[ACC_RANGE]) {
+    case 0x05: accelLsb = 8192; break;
+    case 0x08: accelLsb = 4096; break;
+    case 0x0C: accelLsb = 2048; break;
+    }
+    double gyroLsb = 16.4 * (1 << std::min<int>(regs[GYR_RANGE] & 0x07, 4));
+
+    if (gyroOn) {
+        for (int i = 0; i < 3; ++i)
+            store16(&regs[GYR_DATA + 2 * i], m.gyro[i] * gyroLsb);
+        regs[STATUS] |= DRDY_GYR;
+    }
+    if (accelOn) {
+        for (int i = 0; i < 3; ++i)
+            store16(&regs[ACC_DATA + 2 * i], m.accel[i] * accelLsb);
+        regs[STATUS] |= DRDY_ACC;
+    }
+
+    auto ticks = static_cast<uint32_t>(t / 39.0625e-6) & 0xFFFFFF;
+    regs[SENSORTIME] = ticks & 0xFF;
+    regs[SENSORTIME + 1] = (ticks >> 8) & 0xFF;
+    regs[SENSORTIME + 2] = (ticks >> 16) & 0xFF;
+
+    // Headerless frames hold gyro then accel
+    uint8_t config = regs[FIFO_CONFIG_1];
+    if (!(config & FIFO_HEADER_EN)) {
+        uint8_t frame[12];
+        std::size_t n = 0;
+        if ((config & FIFO_GYR_EN) && gyroOn) {
+            std::copy_n(&regs[GYR_DATA], 6, frame + n);
+            n += 6;
+        }
+        if ((config & FIFO_ACC_EN) && accelOn) {
+            std::copy_n(&regs[ACC_DATA], 6, frame + n);
+            n += 6;
+        }
+        if (n)
+            pushFifo(frame, n);
+    }
+
+    freshSample = true;
+    ++counters.samplesGenerated;
+}
+
+void SimBMI160::pushFifo(const uint8_t *frame, std::size_t n)
+{
+    // Full: the oldest frame is overwritten
+    while (fifoFill + n > fifo.size()) {
+        std::size_t drop = std::min(n, fifoFill);
+        fifoHead = (fifoHead + drop) % fifo.size();
+        fifoFill -= drop;
+        ++counters.fifoOverflows;
+    }
+    for (std::size_t i = 0; i < n; ++i)
+        fifo[(fifoHead + fifoFill + i) % fifo.size()] = frame[i];
+    fifoFill += n;
+}
+
+void SimBMI160::updateInterrupt()
+{
+    bool enabled = regs[INT_OUT_CTRL] & 0x08;
+    std::size_t watermark = regs[FIFO_CONFIG_0] * 4u;
+    bool fwm = (regs[INT_EN_1] & 0x40) && (regs[INT_MAP_1] & 0x40) && watermark && fifoFill >= watermark;
+    bool drdy = (regs[INT_EN_1] & 0x10) && (regs[INT_MAP_1] & 0x80) && freshSample;
+    freshSample = false;
+
+    // The watermark holds the line high until drained, data ready pulses
+    bool level = enabled && fwm;
+    if (int1 && enabled && ((level && !int1Level) || drdy))
+        int1->signal();
+    int1Level = level;
+}
+
+// ------------------------------
+// Register access
+// ------------------------------
+uint8_t SimBMI160::readByte(uint8_t reg)
+{
+    switch (reg) {
+    case FIFO_DATA: {
+        if (fifoFill == 0)
+            return 0x80; // over-read pattern
+        uint8_t value = fifo[fifoHead];
+        fifoHead = (fifoHead + 1) % fifo.size();
+        --fifoFill;
+        return value;
+    }
+    case FIFO_LENGTH_0:
+        return fifoFill & 0xFF;
+    case FIFO_LENGTH_1:
+        return (fifoFill >> 8) & 0x07;
+    case INT_STATUS_1: {
+        std::size_t watermark = regs[FIFO_CONFIG_0] * 4u;
+        uint8_t status = 0;
+        if (watermark && fifoFill >= watermark)
+            status |= 0x40;
+        if (fifoFill + 12 > fifo.size())
+            status |= 0x20;
+        return status;
+    }
+    case GYR_DATA + 5:
+        regs[STATUS] &= ~DRDY_GYR;
+        return regs[reg];
+    case ACC_DATA + 5:
+        regs[STATUS] &= ~DRDY_ACC;
+        return regs[reg];
+    default:
+        return regs[reg & 0x7F];
+    }
+}
+
+void SimBMI160::writeByte(uint8_t reg, uint8_t value)
+{
+    if (reg == CMD) {
+        command(value);
+        return;
+    }
+    if (reg == CHIP_ID || reg == PMU_STATUS || reg == STATUS)
+        return; // read only
+    regs[reg & 0x7F] = value;
+}
+
+void SimBMI160::command(uint8_t cmd)
+{
+    switch (cmd) {
+    case 0x10: accelOn = false; break;
+    case 0x11: accelOn = true; break;
+    case 0x14: gyroOn = false; break;
+    case 0x15: gyroOn = true; break;
+    case 0xB0: fifoHead = fifoFill = 0; break;
+    case 0xB6: reset(); break;
+    }
+    regs[PMU_STATUS] = (accelOn ? 0x10 : 0) | (gyroOn ? 0x04 : 0);
+    if (accelOn || gyroOn)
+        nextSample = std::max(nextSample, now());
+}
+
+int8_t SimBMI160::submit(SPITransaction &t)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        advance();
+
+        for (std::size_t i = 0; i < t.segments(); ++i) {
+            uint8_t *d = t.data(i);
+            uint16_t len = t.length(i);
+            bytes += len;
+            if (len == 0)
+                continue;
+
+            // Bursts auto-increment the address, except on the FIFO data port
+            uint8_t reg = d[0] & 0x7F;
+            bool read = d[0] & 0x80;
+            d[0] = 0;
+            for (uint16_t j = 1; j < len; ++j) {
+                if (read)
+                    d[j] = readByte(reg);
+                else
+                    writeByte(reg, d[j]);
+                if (reg != FIFO_DATA)
+                    reg = (reg + 1) & 0x7F;
+            }
+        }
+        updateInterrupt();
+
+        counters.transactions++;
+        counters.segments += t.segments();
+        counters.bytes += bytes;
+    }
+
+    // Model the time on the wire
+    auto cost = timing.perTransaction + timing.perSegment * t.segments();
+    if (timing.clockHz)
+        cost += std::chrono::nanoseconds(bytes * 8 * 1000000000ull / timing.clockHz);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        counters.busyNs += cost.count();
+    }
+    while (std::chrono::steady_clock::now() - start < cost)
+        ;
+
+    finish(t);
+    return 0;
+}
+
+// ------------------------------
+// Motion and interrupts
+// ------------------------------
+void SimBMI160::setMotion(MotionScript motion)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    script = std::move(motion);
+}
+
+bool SimBMI160::replay(const std::string &csvPath, bool loop)
+{
+    std::ifstream in(csvPath);
+    if (!in) {
+        perror("open()");
+        return false;
+    }
+
+    std::vector<std::array<double, 7>> rows;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::array<double, 7> r{};
+        int n = std::sscanf(line.c_str(), "%lf,%lf,%lf,%lf,%lf,%lf,%lf",
+                            &r[0], &r[1], &r[2], &r[3], &r[4], &r[5], &r[6]);
+        if (n >= 4)
+            rows.push_back(r); // header and malformed lines are skipped
+    }
+    if (rows.empty()) {
+        std::cerr << "[SimBMI160] No samples in " << csvPath << "\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    recording = std::move(rows);
+    script = [this, loop](double t) {
+        double first = recording.front()[0];
+        double length = recording.back()[0] - first;
+        t += first;
+        if (loop && length > 0)
+            t = first + std::fmod(t - first, length);
+
+        // Last row at or before t
+        auto it = std::upper_bound(recording.begin(), recording.end(), t,
+                                   [](double v, const std::array<double, 7> &r) { return v < r[0]; });
+        const auto &r = it == recording.begin() ? *it : *std::prev(it);
+        Motion m;
+        for (int i = 0; i < 3; ++i) {
+            m.accel[i] = r[1 + i];
+            m.gyro[i] = r[4 + i];
+        }
+        return m;
+    };
+    return true;
+}
+
+std::unique_ptr<EventSource> SimBMI160::interrupt()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!int1) {
+        int1 = std::make_unique<ManualEvent>();
+        ticking = true;
+        ticker = std::thread([this]() {
+            while (ticking) {
+                auto wake = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    advance();
+                    updateInterrupt();
+                    // Real time at which the next sample is due
+                    if (odrHz() > 0)
+                        wake = epoch + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                           std::chrono::duration<double>(nextSample / timeScale));
+                }
+                std::this_thread::sleep_until(wake);
+            }
+        });
+    }
+    return int1->listener();
+}
+
+SimBusStats SimBMI160::stats()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return counters;
+}
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include "sim_ssd1306.hpp"
+
+namespace {
+constexpr uint8_t CONTROL_CONTINUATION = 0x80; // Co: one byte, then another control byte
+constexpr uint8_t CONTROL_DATA = 0x40;         // D/C#
+
+// Arguments following a command byte (datasheet section 9)
+int argumentsOf(uint8_t cmd)
+{
+    switch (cmd) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    case 0x21: case 0x22: case 0xA3:
+        return 2;
+    case 0x29: case 0x2A:
+        return 5;
+    case 0x26: case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+} // namespace
+
+SimSSD1306::SimSSD1306(I2CTiming timing, uint8_t address)
+    : timing(timing), address(address)
+{
+}
+
+SimSSD1306::~SimSSD1306()
+{
+    // The flush thread may still be in submit()
+    waitIdle();
+    if (hashLog)
+        std::fclose(hashLog);
+}
+
+std::array<uint8_t, OLED_BUFFER_SIZE> SimSSD1306::framebuffer()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::array<uint8_t, OLED_BUFFER_SIZE> frame;
+    std::memcpy(frame.data(), ram, frame.size());
+    return frame;
+}
+
+uint64_t SimSSD1306::frames()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return frameCount;
+}
+
+bool SimSSD1306::displayOn()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return on;
+}
+
+void SimSSD1306::dumpFrames(const std::string &dir)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    frameDir = dir;
+}
+
+bool SimSSD1306::logHashes(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (hashLog)
+        std::fclose(hashLog);
+    hashLog = std::fopen(path.c_str(), "w");
+    if (!hashLog) {
+        perror("Failed to open frame hash log");
+        return false;
+    }
+    return true;
+}
+
+bool SimSSD1306::writePbm(const std::string &path, const uint8_t *frame)
+{
+    FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        perror("Failed to write PBM frame");
+        return false;
+    }
+
+    // P4: one bit per pixel, rows top to bottom, most significant bit left
+    std::fprintf(f, "P4\n%d %d\n", OLED_WIDTH, OLED_HEIGHT);
+    for (int y = 0; y < OLED_HEIGHT; ++y) {
+        uint8_t row[OLED_WIDTH / 8] = {0};
+        for (int x = 0; x < OLED_WIDTH; ++x)
+            if (frame[(y / 8) * OLED_WIDTH + x] & (1 << (y & 7)))
+                row[x / 8] |= 0x80 >> (x & 7);
+        std::fwrite(row, 1, sizeof(row), f);
+    }
+    return std::fclose(f) == 0;
+}
+
+uint64_t SimSSD1306::hash(const uint8_t *frame)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int i = 0; i < OLED_BUFFER_SIZE; ++i) {
+        h ^= frame[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// ------------------------------
+// Bus
+// ------------------------------
+int8_t SimSSD1306::submit(I2CTransaction &t)
+{
+    auto start = std::chrono::steady_clock::now();
+    countSyscalls(1);
+    if (!t.ok()) {
+        fprintf(stderr, "I2C transaction too large\n");
+        return -2;
+    }
+
+    bool acked = true;
+    uint64_t bits = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (size_t i = 0; i < t.messages() && acked; ++i) {
+            bits += (1 + t.length(i)) * 9 + 2;
+            acked = t.address(i) == address;
+            if (!acked)
+                break;
+            // Status byte: bit 6 is set while the display is off
+            if (t.isRead(i))
+                std::memset(t.data(i), on ? 0x00 : 0x40, t.length(i));
+            else
+                message(t.data(i), t.length(i));
+        }
+    }
+    wait(start, bits, 1);
+
+    if (!acked) {
+        fprintf(stderr, "SimSSD1306: no acknowledge\n");
+        return -2;
+    }
+    finish(t);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    endFrame();
+    return 0;
+}
+
+int8_t SimSSD1306::transmit(uint8_t slaveAddress, const uint8_t *buf, uint16_t length)
+{
+    auto start = std::chrono::steady_clock::now();
+    countSyscalls(1);
+
+    bool acked = slaveAddress == address;
+    if (acked) {
+        std::lock_guard<std::mutex> lock(mtx);
+        message(buf, length);
+    }
+    wait(start, (1 + length) * 9 + 2, 1);
+    return acked ? 0 : -2;
+}
+
+int8_t SimSSD1306::receive(uint8_t slaveAddress, uint8_t *buf, uint16_t length)
+{
+    auto start = std::chrono::steady_clock::now();
+    countSyscalls(1);
+
+    bool acked = slaveAddress == address;
+    if (acked) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::memset(buf, on ? 0x00 : 0x40, length);
+    }
+    wait(start, (1 + length) * 9 + 2, 1);
+    return acked ? 0 : -2;
+}
+
+void SimSSD1306::wait(std::chrono::steady_clock::time_point start, uint64_t bits, int transfers)
+{
+    auto cost = timing.perTransfer * transfers;
+    if (timing.clockHz)
+        cost += std::chrono::nanoseconds(bits * 1000000000ull / timing.clockHz);
+    while (std::chrono::steady_clock::now() - start < cost)
+        ;
+}
+
+// ------------------------------
+// Controller
+// ------------------------------
+// One I2C write: control byte, then commands or data. With Co set the
+// control byte covers a single byte and another control byte follows.
+void SimSSD1306::message(const uint8_t *data, uint16_t length)
+{
+    uint16_t i = 0;
+    while (i < length) {
+        uint8_t control = data[i++];
+        bool isData = control & CONTROL_DATA;
+        uint16_t end = (control & CONTROL_CONTINUATION) ? std::min<uint16_t>(i + 1, length) : length;
+        for (; i < end; ++i) {
+            if (isData)
+                dataByte(data[i]);
+            else
+                commandByte(data[i]);
+        }
+    }
+}
+
+void SimSSD1306::commandByte(uint8_t byte)
+{
+    cmd[cmdLength++] = byte;
+    if (cmdLength > argumentsOf(cmd[0])) {
+        execute();
+        cmdLength = 0;
+    }
+}
+
+void SimSSD1306::execute()
+{
+    uint8_t c = cmd[0];
+    if (c == 0x20) {
+        mode = cmd[1] & 0x03;
+    }
+    else if (c == 0x21) {
+        columnStart = cmd[1] & 0x7F;
+        columnEnd = cmd[2] & 0x7F;
+        column = columnStart;
+    }
+    else if (c == 0x22) {
+        pageStart = cmd[1] & 0x07;
+        pageEnd = cmd[2] & 0x07;
+        page = pageStart;
+    }
+    else if (c == 0xAE || c == 0xAF) {
+        on = c == 0xAF;
+    }
+    else if (mode == 2 && c <= 0x0F) {
+        column = (column & 0xF0) | c;
+    }
+    else if (mode == 2 && c >= 0x10 && c <= 0x1F) {
+        column = ((c & 0x07) << 4) | (column & 0x0F);
+    }
+    else if (mode == 2 && c >= 0xB0 && c <= 0xB7) {
+        page = c & 0x07;
+    }
+}
+
+void SimSSD1306::dataByte(uint8_t byte)
+{
+    ram[page][column] = byte;
+
+    if (mode == 0) { // horizontal: along the column window, then the next page
+        if (++column > columnEnd) {
+            column = columnStart;
+            if (++page > pageEnd)
+                page = pageStart;
+        }
+    }
+    else if (mode == 1) { // vertical: down the page window, then the next column
+        if (++page > pageEnd) {
+            page = pageStart;
+            if (++column > columnEnd)
+                column = columnStart;
+        }
+    }
+    else if (++column > OLED_WIDTH - 1) { // page: wraps within the page
+        column = 0;
+    }
+}
+
+void SimSSD1306::endFrame()
+{
+    ++frameCount;
+    const uint8_t *frame = &ram[0][0];
+
+    if (!frameDir.empty()) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/frame_%06" PRIu64 ".pbm", frameCount);
+        writePbm(frameDir + name, frame);
+    }
+    if (hashLog)
+        std::fprintf(hashLog, "%" PRIu64 " %016" PRIx64 "\n", frameCount, hash(frame));
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "sprite.hpp"
+
+// Applies op(byte, bits) to the columns and pages the sprite covers
+template <typename Op>
+static void applySprite(uint8_t *frame, int x, int y, const ShiftedSprite &sprite, Op op)
+{
+    if (x <= -8 || x >= OLED_WIDTH || y <= -8 || y >= OLED_HEIGHT)
+        return;
+
+    int page = y >> 3; // rounds down, also for negative y
+    int shift = y & 7;
+    int c0 = std::max(0, -x);
+    int c1 = std::min(8, OLED_WIDTH - x);
+
+    if (page >= 0) {
+        uint8_t *dst = frame + page * OLED_WIDTH + x;
+        const uint8_t *top = sprite.top[shift];
+        for (int c = c0; c < c1; ++c)
+            dst[c] = op(dst[c], top[c]);
+    }
+    if (shift != 0 && page + 1 < OLED_PAGES) {
+        uint8_t *dst = frame + (page + 1) * OLED_WIDTH + x;
+        const uint8_t *bottom = sprite.bottom[shift];
+        for (int c = c0; c < c1; ++c)
+            dst[c] = op(dst[c], bottom[c]);
+    }
+}
+
+void blitSprite(uint8_t *frame, int x, int y, const ShiftedSprite &sprite)
+{
+    applySprite(frame, x, y, sprite, [](uint8_t d, uint8_t s) { return uint8_t(d | s); });
+}
+
+void eraseSprite(uint8_t *frame, int x, int y, const ShiftedSprite &sprite)
+{
+    applySprite(frame, x, y, sprite, [](uint8_t d, uint8_t s) { return uint8_t(d & ~s); });
+}
+
+// ---------------------------
+// 5x7 font, the characters "Score <n>" needs
+// ---------------------------
+struct Glyph {
+    char c;
+    uint8_t columns[5];
+};
+
+static const Glyph font[] = {
+    {'0', {0x3E, 0x51, 0x49, 0x45, 0x3E}},
+    {'1', {0x00, 0x42, 0x7F, 0x40, 0x00}},
+    {'2', {0x42, 0x61, 0x51, 0x49, 0x46}},
+    {'3', {0x21, 0x41, 0x45, 0x4B, 0x31}},
+    {'4', {0x18, 0x14, 0x12, 0x7F, 0x10}},
+    {'5', {0x27, 0x45, 0x45, 0x45, 0x39}},
+    {'6', {0x3C, 0x4A, 0x49, 0x49, 0x30}},
+    {'7', {0x01, 0x71, 0x09, 0x05, 0x03}},
+    {'8', {0x36, 0x49, 0x49, 0x49, 0x36}},
+    {'9', {0x06, 0x49, 0x49, 0x29, 0x1E}},
+    {'-', {0x08, 0x08, 0x08, 0x08, 0x08}},
+    {'S', {0x46, 0x49, 0x49, 0x49, 0x31}},
+    {'c', {0x38, 0x44, 0x44, 0x44, 0x20}},
+    {'e', {0x38, 0x54, 0x54, 0x54, 0x18}},
+    {'o', {0x38, 0x44, 0x44, 0x44, 0x38}},
+    {'r', {0x7C, 0x08, 0x04, 0x04, 0x08}},
+};
+
+static const uint8_t blank[5] = {0};
+
+const uint8_t *glyph5x7(char c)
+{
+    for (const Glyph &g : font)
+        if (g.c == c)
+            return g.columns;
+    return blank;
+}
+
+// ---------------------------
+// ScoreText
+// ---------------------------
+void ScoreText::render(int score)
+{
+    char text[24];
+    int length = std::snprintf(text, sizeof(text), "Score %d", score);
+    int width = std::min(length * 6, OLED_WIDTH);
+
+    std::memset(columns, 0, sizeof(columns));
+    for (int i = 0; i < length && i * 6 + 5 <= OLED_WIDTH; ++i)
+        std::memcpy(columns + i * 6, glyph5x7(text[i]), 5);
+
+    // Keep writing the blank columns of a longer text drawn before
+    span = std::max(span, width);
+    cachedScore = score;
+    valid = true;
+    ++renderCount;
+}
+
+void ScoreText::draw(uint8_t *frame, int score)
+{
+    if (!valid || score != cachedScore)
+        render(score);
+    std::memcpy(frame, columns, span);
+}
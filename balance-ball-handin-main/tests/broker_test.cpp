@@ -0,0 +1,176 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "broker.hpp"
+
+// Broker behaviour that the benchmarks don't show, no hardware needed.
+//
+//   prune    a subscriber of every delivery mode is pruned from the table
+//            once its consumer is destroyed without unsubscribing
+//   latest   Latest conflates each topic in its own slot, so one topic of a
+//            wildcard subscription never overwrites another
+//   options  a subscription with other options than the consumer's
+//            existing one gets its own dispatcher
+
+using Clock = std::chrono::steady_clock;
+
+class CountingConsumer : public IConsumer {
+public:
+  std::atomic<uint64_t> count{0};
+  void onMessage(const Message &) override { count.fetch_add(1, std::memory_order_relaxed); }
+};
+
+static const char *modeName(DeliveryMode mode) {
+  switch (mode) {
+  case DeliveryMode::Sync: return "sync";
+  case DeliveryMode::Async: return "async";
+  case DeliveryMode::Latest: return "latest";
+  }
+  return "?";
+}
+
+// Drops a consumer without unsubscribing; the next publish must get it pruned
+static bool testPrune(DeliveryMode mode) {
+  Broker &broker = Broker::getInstance();
+  std::size_t before = broker.subscriberCount(topics::accl);
+
+  SubscriptionOptions options;
+  options.mode = mode;
+  auto consumer = std::make_shared<CountingConsumer>();
+  broker.subscribe(topics::accl, consumer, options);
+  broker.publish(topics::accl, AccelerometerData{});
+  consumer.reset();
+  broker.publish(topics::accl, AccelerometerData{});
+
+  auto deadline = Clock::now() + std::chrono::seconds(2);
+  while (broker.subscriberCount(topics::accl) != before) {
+    if (Clock::now() > deadline) {
+      std::cerr << "prune: expired " << modeName(mode) << " subscriber was not pruned\n";
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// Blocks in onMessage on the first message of holdTopic until released,
+// so messages pile up behind it
+class SlowConsumer : public IConsumer {
+public:
+  TopicId holdTopic;
+  std::atomic<bool> hold{true};
+  std::atomic<bool> holding{false};
+  std::atomic<int> delivered{0};
+
+  explicit SlowConsumer(TopicId holdTopic) : holdTopic(holdTopic) {}
+
+  void onMessage(const Message &msg) override {
+    if (msg.topic == holdTopic && hold) {
+      holding = true;
+      while (hold)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (auto *a = msg.get<AccelerometerData>()) {
+      std::lock_guard<std::mutex> lock(mtx);
+      last[msg.topic] = a->x;
+    }
+    delivered.fetch_add(1);
+  }
+
+  double lastOf(TopicId topic) {
+    std::lock_guard<std::mutex> lock(mtx);
+    return last.count(topic) ? last[topic] : -1;
+  }
+
+private:
+  std::mutex mtx;
+  std::map<TopicId, double> last;
+};
+
+static bool waitFor(const std::atomic<int> &count, int n) {
+  auto deadline = Clock::now() + std::chrono::seconds(2);
+  while (count.load() < n && Clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return count.load() >= n;
+}
+
+static bool waitFor(const std::atomic<bool> &flag) {
+  auto deadline = Clock::now() + std::chrono::seconds(2);
+  while (!flag && Clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return flag;
+}
+
+static bool testLatestPerTopic() {
+  Broker &broker = Broker::getInstance();
+  auto a = broker.registerTopic<AccelerometerData>("test/latest/a");
+  auto b = broker.registerTopic<AccelerometerData>("test/latest/b");
+
+  SubscriptionOptions options;
+  options.mode = DeliveryMode::Latest;
+  auto consumer = std::make_shared<SlowConsumer>(a.id);
+  broker.subscribe("test/latest/+", consumer, options);
+
+  // While the consumer is busy with a 0, a and b get three updates each
+  broker.publish(a, AccelerometerData{0, 0, 0});
+  bool ok = waitFor(consumer->holding);
+  for (double x : {1, 2, 3}) {
+    broker.publish(a, AccelerometerData{x, 0, 0});
+    broker.publish(b, AccelerometerData{10 + x, 0, 0});
+  }
+  consumer->hold = false;
+
+  // Then it must get the newest of each, and nothing else
+  ok = ok && waitFor(consumer->delivered, 3);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  SubscriptionStats stats = broker.stats("test/latest/+", consumer);
+  ok = ok && consumer->delivered == 3 && consumer->lastOf(a.id) == 3 && consumer->lastOf(b.id) == 13 &&
+       stats.coalesced == 4;
+  if (!ok)
+    std::cerr << "latest: " << consumer->delivered << " delivered, last a " << consumer->lastOf(a.id) << ", last b "
+              << consumer->lastOf(b.id) << ", " << stats.coalesced << " coalesced; expected 3, 3, 13, 4\n";
+
+  broker.unsubscribe("test/latest/+", consumer);
+  return ok;
+}
+
+static bool testOptions() {
+  Broker &broker = Broker::getInstance();
+  auto held = broker.registerTopic<AccelerometerData>("test/options/latest");
+  auto queued = broker.registerTopic<AccelerometerData>("test/options/async");
+
+  SubscriptionOptions latest, async;
+  latest.mode = DeliveryMode::Latest;
+  async.mode = DeliveryMode::Async;
+  auto consumer = std::make_shared<SlowConsumer>(held.id);
+  broker.subscribe(held, consumer, latest);
+  broker.subscribe(queued, consumer, async);
+
+  // The Latest thread is blocked; the async messages must neither wait
+  // for it nor be conflated
+  broker.publish(held, AccelerometerData{});
+  bool ok = waitFor(consumer->holding);
+  for (int i = 0; i < 5; ++i)
+    broker.publish(queued, AccelerometerData{double(i), 0, 0});
+  ok = ok && waitFor(consumer->delivered, 5) && broker.stats(queued, consumer).coalesced == 0;
+  if (!ok)
+    std::cerr << "options: " << consumer->delivered << " of 5 async messages delivered\n";
+
+  consumer->hold = false;
+  broker.unsubscribe(held, consumer);
+  broker.unsubscribe(queued, consumer);
+  return ok;
+}
+
+int main() {
+  bool ok = true;
+  for (auto mode : {DeliveryMode::Sync, DeliveryMode::Async, DeliveryMode::Latest})
+    ok &= testPrune(mode);
+  ok &= testLatestPerTopic();
+  ok &= testOptions();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "sample_decode.hpp"
+
+// decodeFrames (NEON, SSE2 or scalar) against decodeFramesScalar, the
+// reference, bit for bit on random and extreme int16 values for every
+// batch size up to 64 frames, with accelerometer-only (6 byte) and
+// gyro+accel (12 byte) frames. Builds without the SYSHAT header.
+
+// Scales of a BMI160 frame: gyro (degrees/s) then accelerometer (g)
+static const float scales[2] = {1 / 16.4f, 1 / 16384.0f};
+
+struct Output {
+  std::vector<float> data;
+  Vec3Array arrays[2];
+
+  explicit Output(std::size_t frames) : data(6 * frames) {
+    for (int s = 0; s < 2; ++s)
+      arrays[s] = {&data[(3 * s) * frames], &data[(3 * s + 1) * frames], &data[(3 * s + 2) * frames]};
+  }
+};
+
+static std::vector<uint8_t> randomFrames(std::size_t frames, int sensors, std::mt19937 &rng) {
+  std::vector<uint8_t> raw(frames * sensors * 6);
+  std::uniform_int_distribution<int> byte(0, 255);
+  for (auto &b : raw)
+    b = static_cast<uint8_t>(byte(rng));
+
+  // Extremes and the values around the sign change in the first frames
+  const int16_t edges[] = {-32768, 32767, -1, 0, 1, -256, 255, 256, -255};
+  for (std::size_t i = 0; i < std::size(edges) && 2 * i + 1 < raw.size(); ++i) {
+    raw[2 * i] = static_cast<uint8_t>(edges[i] & 0xFF);
+    raw[2 * i + 1] = static_cast<uint8_t>((edges[i] >> 8) & 0xFF);
+  }
+  return raw;
+}
+
+int main() {
+  std::mt19937 rng(18);
+  for (int sensors = 1; sensors <= 2; ++sensors) {
+    for (std::size_t frames = 0; frames <= 64; ++frames) {
+      auto raw = randomFrames(frames, sensors, rng);
+      Output expected(frames), actual(frames);
+      decodeFramesScalar(raw.data(), frames, sensors, scales, expected.arrays);
+      decodeFrames(raw.data(), frames, sensors, scales, actual.arrays);
+
+      for (int s = 0; s < sensors; ++s) {
+        for (std::size_t f = 0; f < frames; ++f) {
+          const float *e[3] = {expected.arrays[s].x, expected.arrays[s].y, expected.arrays[s].z};
+          const float *a[3] = {actual.arrays[s].x, actual.arrays[s].y, actual.arrays[s].z};
+          for (int k = 0; k < 3; ++k) {
+            if (std::memcmp(&e[k][f], &a[k][f], sizeof(float)) != 0) {
+              std::cerr << "decode mismatch: " << decodeKernelName() << " sensors " << sensors << " frames "
+                        << frames << " frame " << f << " sensor " << s << " axis " << k << ": " << a[k][f]
+                        << " != " << e[k][f] << "\n";
+              return 1;
+            }
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
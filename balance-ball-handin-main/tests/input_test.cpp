@@ -0,0 +1,100 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include "broker.hpp"
+#include "input_thread.hpp"
+
+// Buttons without hardware, no device nodes needed.
+//
+//   debounce   a bouncing press on a pipe is published as one change
+//   fallback   a button on a file (which epoll refuses, like a driver
+//              without poll) stays with the caller and readLoop publishes it
+
+class ButtonConsumer : public IConsumer {
+public:
+  std::atomic<int> count{0};
+  std::atomic<int> level{-1};
+
+  void onButton(const ButtonData &data) override {
+    level = data.value;
+    count.fetch_add(1);
+  }
+};
+
+static bool waitFor(const std::atomic<int> &count, int n) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (count.load() < n && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return count.load() >= n;
+}
+
+static bool testDebounce(Topic<ButtonData> topic) {
+  auto consumer = std::make_shared<ButtonConsumer>();
+  Broker::getInstance().subscribe(topic, consumer);
+
+  int fds[2];
+  if (pipe(fds) < 0) {
+    perror("pipe()");
+    return false;
+  }
+  InputThread input;
+  auto button = std::make_unique<Button>(fds[0], 0, topic);
+  bool added = input.add(button);
+  std::thread reader([&input]() { input.run(); });
+
+  // Released, then one press bouncing within the debounce window
+  bool written = write(fds[1], "1", 1) == 1 && waitFor(consumer->count, 1) && write(fds[1], "01010", 5) == 5;
+  bool ok = added && !button && written && waitFor(consumer->count, 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ok = ok && consumer->count == 2 && consumer->level == 0;
+
+  input.stop();
+  reader.join();
+  close(fds[1]);
+  Broker::getInstance().unsubscribe(topic, consumer);
+  if (!ok)
+    std::cerr << "debounce: " << consumer->count << " changes published, expected 2\n";
+  return ok;
+}
+
+static bool testFallback(Topic<ButtonData> topic) {
+  auto consumer = std::make_shared<ButtonConsumer>();
+  Broker::getInstance().subscribe(topic, consumer);
+
+  char path[] = "/tmp/input_testXXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0 || write(fd, "0", 1) != 1 || lseek(fd, 0, SEEK_SET) < 0) {
+    perror("input_test file");
+    return false;
+  }
+  unlink(path);
+
+  InputThread input;
+  auto button = std::make_unique<Button>(fd, 1, topic);
+  bool ok = !input.add(button) && button && button->isOpen();
+  if (ok) {
+    Button *b = button.get();
+    std::thread t([b]() { b->readLoop(); });
+    ok = waitFor(consumer->count, 1) && consumer->level == 0;
+    b->stop();
+    t.join();
+  }
+
+  Broker::getInstance().unsubscribe(topic, consumer);
+  if (!ok)
+    std::cerr << "fallback: an unpollable button was not kept or not read\n";
+  return ok;
+}
+
+int main() {
+  auto debounceTopic = Broker::getInstance().registerTopic<ButtonData>("test/btn/0");
+  auto fallbackTopic = Broker::getInstance().registerTopic<ButtonData>("test/btn/1");
+
+  bool ok = testDebounce(debounceTopic);
+  ok &= testFallback(fallbackTopic);
+  return ok ? 0 : 1;
+}
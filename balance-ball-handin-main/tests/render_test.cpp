@@ -0,0 +1,43 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "display.hpp"
+#include "sim_ssd1306.hpp"
+
+// Display on the simulated SSD1306: after every frame of a random sequence
+// (small steps, jumps, repeated states, changing scores) the panel must
+// show exactly the page buffer, so the diffed and batched writes lose
+// nothing. Needs the SYSHAT header but no Pi.
+
+int main() {
+  SimSSD1306 sim(I2CTiming::instant());
+  uint8_t buffer[OLED_BUFFER_SIZE];
+  Display display(sim, buffer);
+
+  std::mt19937 rng(24);
+  std::uniform_int_distribution<int> x(-10, OLED_WIDTH + 2), y(-10, OLED_HEIGHT + 2);
+  std::uniform_int_distribution<int> score(-30000, 30000), pick(0, 3);
+
+  GameState state{64, 16, 0};
+  for (int i = 0; i < 20000; ++i) {
+    int p = pick(rng);
+    if (p == 0) {
+      state.ball_x = x(rng);
+      state.ball_y = y(rng);
+    } else if (p == 1) {
+      state.ball_x += pick(rng) - 1;
+      state.ball_y += pick(rng) - 1;
+    } else if (p == 2) {
+      state.score = score(rng);
+    }
+
+    display.drawDisplay(state);
+    sim.waitIdle();
+    if (std::memcmp(sim.framebuffer().data(), buffer, OLED_BUFFER_SIZE) != 0) {
+      std::cerr << "panel differs from the page buffer after frame " << i << ", ball (" << state.ball_x
+                << ", " << state.ball_y << "), score " << state.score << "\n";
+      return 1;
+    }
+  }
+  return 0;
+}
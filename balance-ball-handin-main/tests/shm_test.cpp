@@ -0,0 +1,66 @@
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include "broker.hpp"
+#include "shm_transport.hpp"
+
+// The shared memory ring across writer restarts, in one process: the
+// publisher is fed directly, so its records don't loop back into it.
+//
+//   crash     a new run replaces the segment of a run that never cleaned up,
+//             and an attached reader follows it without losing records
+//   restart   after a clean exit the reader waits, then attaches to the
+//             next run
+
+class CountingConsumer : public IConsumer {
+public:
+  std::atomic<uint64_t> count{0};
+  void onMessage(const Message &) override { count.fetch_add(1, std::memory_order_relaxed); }
+};
+
+static void publish(ShmPublisher &publisher, Topic<AccelerometerData> topic, int n) {
+  for (int i = 0; i < n; ++i)
+    publisher.onMessage(*makeMessage(topic.id, AccelerometerData{double(i), 0, 0}));
+}
+
+static bool check(const char *name, std::size_t pumped, std::size_t expected, const ShmSubscriber &subscriber) {
+  if (pumped == expected && subscriber.lostRecords() == 0)
+    return true;
+  std::cerr << name << ": " << pumped << " records, " << subscriber.lostRecords() << " lost; expected " << expected
+            << ", 0\n";
+  return false;
+}
+
+int main() {
+  Broker &broker = Broker::getInstance();
+  auto topic = broker.registerTopic<AccelerometerData>("test/shm/accl");
+  auto consumer = std::make_shared<CountingConsumer>();
+  broker.subscribe(topic, consumer);
+  std::string name = "/shm_test_" + std::to_string(getpid());
+
+  // Never destroyed, like a run that crashed
+  auto *crashed = new ShmPublisher(name, 16);
+  ShmSubscriber subscriber(name);
+  subscriber.subscribe("test/shm/#");
+  if (!crashed->isOpen() || !subscriber.isOpen())
+    return 1;
+  publish(*crashed, topic, 5);
+  bool ok = check("first run", subscriber.pump(), 5, subscriber);
+
+  auto next = std::make_unique<ShmPublisher>(name, 16);
+  publish(*next, topic, 3);
+  ok &= check("crash", subscriber.pump(), 3, subscriber) && subscriber.isOpen();
+
+  next.reset();
+  ok &= check("exit", subscriber.pump(), 0, subscriber) && !subscriber.isOpen();
+  next = std::make_unique<ShmPublisher>(name, 16);
+  publish(*next, topic, 2);
+  ok &= check("restart", subscriber.pump(), 2, subscriber) && subscriber.isOpen();
+
+  ok &= consumer->count == 10;
+  if (consumer->count != 10)
+    std::cerr << "shm: " << consumer->count << " of 10 records republished\n";
+  return ok ? 0 : 1;
+}
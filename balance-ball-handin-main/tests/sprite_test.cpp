@@ -0,0 +1,36 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "sprite_paths.hpp"
+
+// The blitter (erase, cached score, pre-shifted ball) against drawing
+// pixel by pixel, on random states with partly off screen balls and
+// scores that are kept, replaced or shortened. No hardware needed.
+
+int main() {
+  std::mt19937 rng(22);
+  std::uniform_int_distribution<int> x(-10, OLED_WIDTH + 2), y(-10, OLED_HEIGHT + 2);
+  std::uniform_int_distribution<int> score(-30000, 30000), change(0, 3);
+
+  uint8_t expected[OLED_BUFFER_SIZE], actual[OLED_BUFFER_SIZE] = {0};
+  Blitter blitter;
+  GameState state{64, 16, 0};
+  for (int i = 0; i < 200000; ++i) {
+    state.ball_x = x(rng);
+    state.ball_y = y(rng);
+    // Keep the score (and its cache) some of the time, shrink it now and then
+    if (change(rng) == 0)
+      state.score = score(rng);
+    else if (change(rng) == 0)
+      state.score /= 10;
+
+    drawReference(expected, state);
+    blitter.draw(actual, state);
+    if (std::memcmp(expected, actual, OLED_BUFFER_SIZE) != 0) {
+      std::cerr << "frame mismatch at ball (" << state.ball_x << ", " << state.ball_y << "), score "
+                << state.score << "\n";
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include "broker.hpp"
+#include "journal.hpp"
+#include "logger.hpp"
+
+// Counts what is replayed, for throughput numbers without console output
+class CountingConsumer : public IConsumer
+{
+public:
+  uint64_t count = 0;
+  void onMessage(const Message &) override { ++count; }
+};
+
+// Usage: journal_replay <journal> [speed] [-q]
+//   speed 1 = original timing (default), N = N times faster, 0 = as fast as possible
+//   -q    = don't print the messages
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <journal> [speed] [-q]\n";
+    return 1;
+  }
+
+  double speed = 1.0;
+  bool quiet = false;
+  for (int i = 2; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-q") == 0)
+      quiet = true;
+    else
+      speed = std::atof(argv[i]);
+  }
+
+  JournalReplayer replayer(argv[1]);
+  if (!replayer.isOpen())
+    return 1;
+
+  auto counter = std::make_shared<CountingConsumer>();
+  Broker::getInstance().subscribe("#", counter);
+
+  auto logger = std::make_shared<Logger>();
+  if (!quiet)
+    Broker::getInstance().subscribe("#", logger);
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t replayed = replayer.replay(speed);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "replayed " << replayed << " messages (" << counter->count << " delivered) in "
+            << elapsed.count() << " s, " << replayed / elapsed.count() << " msg/s\n";
+  return 0;
+}
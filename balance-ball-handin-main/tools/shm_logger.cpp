@@ -0,0 +1,44 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include "broker.hpp"
+#include "logger.hpp"
+#include "shm_transport.hpp"
+
+// Out-of-process logger: prints the topics exported by balance_ball.
+// Usage: shm_logger [pattern...]   (default "#")
+int main(int argc, char *argv[]) {
+  ShmSubscriber subscriber("/balance_ball");
+  if (!subscriber.isOpen())
+    return 1;
+
+  if (argc < 2)
+    subscriber.subscribe("#");
+  for (int i = 1; i < argc; ++i)
+    subscriber.subscribe(argv[i]);
+
+  auto logger = std::make_shared<Logger>();
+  Broker::getInstance().subscribe("#", logger);
+
+  // Keeps running when balance_ball exits, and follows its next run
+  uint64_t lost = 0;
+  bool open = true;
+  while (true) {
+    // Without a writer every pump() tries to attach, so poll slower
+    if (subscriber.pump() == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(subscriber.isOpen() ? 1 : 100));
+
+    if (subscriber.isOpen() != open) {
+      open = subscriber.isOpen();
+      std::cerr << "[shm_logger] " << (open ? "writer attached" : "writer gone, waiting") << "\n";
+    }
+
+    if (subscriber.lostRecords() != lost) {
+      lost = subscriber.lostRecords();
+      std::cerr << "[shm_logger] lost " << lost << " records\n";
+    }
+  }
+
+  return 0;
+}
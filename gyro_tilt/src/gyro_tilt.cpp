@@ -1,8 +1,13 @@
+#include <cerrno>
 #include <cstdint>
 #include <cstring>
+#include <cstdlib>
 #include <fcntl.h>
+#include <linux/gpio.h>
 #include <linux/spi/spidev.h>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 #include <iostream>
 
@@ -11,6 +16,9 @@
 #define BMI160_GYRO_REG 0x0C
 #define BMI160_STATUS_REG 0x1B
 #define BMI160_READ_BIT 0x80
+#define BMI160_INT_EN_1 0x51
+#define BMI160_INT_OUT_CTRL 0x53
+#define BMI160_INT_MAP_1 0x56
 
 #define BMI160_GYRO_SENS 16.4
 
@@ -18,6 +26,9 @@
 #define SPI_SPEED 1000000 // 1 MHz
 #define SPI_BITS_PER_WORD 8
 
+#define GPIO_CHIP "/dev/gpiochip0"
+#define SAMPLE_PERIOD_NS 100000000 // fallback timer, 10 Hz
+
 #define MAXBUFSIZE 32
 
 int8_t fd = -1;
@@ -137,26 +148,101 @@ void readGyro(void) {
   }
 }
 
+// Route gyro data ready to INT1 and wait for its rising edges on a GPIO line
+int openDataReadyLine(unsigned line) {
+  writeReg(BMI160_INT_OUT_CTRL, 0x0A); // INT1 output enabled, push-pull, active high
+  writeReg(BMI160_INT_MAP_1, 0x80);    // data ready -> INT1
+  writeReg(BMI160_INT_EN_1, 0x10);     // data ready interrupt enabled
+
+  int chip = open(GPIO_CHIP, O_RDONLY);
+  if (chip < 0) {
+    perror("open()");
+    return -1;
+  }
+  struct gpioevent_request req;
+  memset(&req, 0, sizeof(req));
+  req.lineoffset = line;
+  req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+  req.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
+  strncpy(req.consumer_label, "gyro_tilt", sizeof(req.consumer_label) - 1);
+  int ret = ioctl(chip, GPIO_GET_LINEEVENT_IOCTL, &req);
+  close(chip);
+  if (ret < 0) {
+    perror("GPIO_GET_LINEEVENT_IOCTL");
+    return -1;
+  }
+  return req.fd;
+}
+
+// Fallback without interrupt line: a periodic timer
+int openSampleTimer(void) {
+  int tfd = timerfd_create(CLOCK_MONOTONIC, 0);
+  if (tfd < 0) {
+    perror("timerfd_create()");
+    return -1;
+  }
+  struct itimerspec spec;
+  spec.it_interval.tv_sec = 0;
+  spec.it_interval.tv_nsec = SAMPLE_PERIOD_NS;
+  spec.it_value = spec.it_interval;
+  timerfd_settime(tfd, 0, &spec, nullptr);
+  return tfd;
+}
+
 // Main
+// Usage: gyro_tilt [gpio line wired to INT1]
 int main(int argc, char* argv[]) {
   initSPI();
 
   startGyro();
 
-  while ( isGyroDataAvailable() ) {
+  bool interrupt = argc > 1;
+  int efd = interrupt ? openDataReadyLine(atoi(argv[1])) : openSampleTimer();
+  if (efd < 0) {
+    close(fd);
+    exit(EXIT_FAILURE);
+  }
+
+  struct pollfd pfd = {efd, POLLIN, 0};
+  while (true) {
+    // Sleep until the next edge/tick, read the sensor only if it has data
+    if (poll(&pfd, 1, 1000) < 0) {
+      perror("poll()");
+      break;
+    }
+    if (pfd.revents & POLLIN) {
+      // Consume the edge/tick, or poll() returns at once from now on
+      struct gpioevent_data event;
+      uint64_t expirations;
+      void *dst = interrupt ? (void *)&event : (void *)&expirations;
+      ssize_t size = interrupt ? sizeof(event) : sizeof(expirations);
+      ssize_t n = read(efd, dst, size);
+      if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        perror("read()");
+        break;
+      }
+      if (n >= 0 && n != size) {
+        std::cerr << "Short read of " << n << " bytes from the sample event\n";
+        break;
+      }
+    }
+    if (!isGyroDataAvailable())
+      continue;
+
     readGyro();
 
-    double gx = (double)(((int8_t)buffer[1] << 8 | (int8_t)buffer[0]) / BMI160_GYRO_SENS);
-    double gy = (double)(((int8_t)buffer[3] << 8 | (int8_t)buffer[2]) / BMI160_GYRO_SENS);
-    double gz = (double)(((int8_t)buffer[5] << 8 | (int8_t)buffer[4]) / BMI160_GYRO_SENS);
+    // Little-endian int16 per axis. Only the assembled value is signed, a
+    // sign-extended low byte would clobber the high byte.
+    double gx = (int16_t)(buffer[1] << 8 | buffer[0]) / BMI160_GYRO_SENS;
+    double gy = (int16_t)(buffer[3] << 8 | buffer[2]) / BMI160_GYRO_SENS;
+    double gz = (int16_t)(buffer[5] << 8 | buffer[4]) / BMI160_GYRO_SENS;
 
     std::cout << "gx: " << gx << "        \t";
     std::cout << "gy: " << gy << "        \t";
     std::cout << "gz: " << gz << "\n";
-
-    usleep(100000);
   }
 
+  close(efd);
   close(fd);
 
   return EXIT_SUCCESS;